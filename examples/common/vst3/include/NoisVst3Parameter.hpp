@@ -25,6 +25,7 @@ public:
 
 	virtual void Setup(nois::count_t numFrames, nois::f32_t sampleRate) = 0;
 
+	// Value from frame on, frames ascend within a block
 	virtual void WritePlain(nois::count_t frame, nois::f32_t valuePlain) = 0;
 	virtual void RequestPlain(nois::f32_t valuePlain) = 0;
 	virtual nois::f32_t GetLastPlain() const = 0;
@@ -181,18 +182,11 @@ class NoisVstProcessorParameterImpl : public NoisVstProcessorParameter
 
 public:
 	NoisVstProcessorParameterImpl(nois::FloatRegistry& registry)
-		: mNumFrames(0)
-		, mSampleRate(0.0f)
-		, mRegistry(registry)
+		: mRegistry(registry)
 		, mParameter(nullptr)
 		, mNextValue(std::nullopt)
-		, mValues()
 	{
-		mParameter = mRegistry.CreateSampleBinder(
-			[this](nois::count_t f)
-			{
-				return GetValue(f);
-			});
+		mParameter = mRegistry.CreateAutomation(Param::kDefaultValue);
 	}
 
 	Vst::ParamID GetPid() const override final
@@ -217,32 +211,17 @@ public:
 
 	void Setup(nois::count_t numFrames, nois::f32_t sampleRate) override final
 	{
-		nois::f32_t lastPlain = Param::kDefaultValue;
-		if (!mValues.empty())
-		{
-			lastPlain = GetLastPlain();
-		}
-		if (numFrames != mNumFrames)
+		if (mNextValue)
 		{
-			mValues.resize(numFrames, lastPlain);
+			mParameter->AddOrReplaceLast(0, *mNextValue);
+			mNextValue = std::nullopt;
 		}
-
-		nois::f32_t fillPlain = mNextValue.value_or(lastPlain);
-		mNextValue = std::nullopt;
-
-		// TODO: move me to setup parameters stage
-		std::fill(mValues.begin(), mValues.end(), fillPlain);
-
-		mNumFrames = numFrames;
-		mSampleRate = sampleRate;
 	}
 
 	void WritePlain(nois::count_t f, nois::f32_t valuePlain) override final
 	{
-		if (f < mValues.size())
-		{
-			mValues[f] = valuePlain;
-		}
+		// Hosts can send more points than fit, the last one always lands
+		mParameter->AddOrReplaceLast(f, valuePlain);
 	}
 
 	void RequestPlain(nois::f32_t valuePlain) override final
@@ -252,12 +231,7 @@ public:
 
 	nois::f32_t GetLastPlain() const override final
 	{
-		if (!mValues.empty())
-		{
-			return mValues.back();
-		}
-
-		return Param::kDefaultValue;
+		return mParameter->GetLastValue();
 	}
 
 	operator nois::Ref_t<nois::FloatParameter>() override final
@@ -271,18 +245,9 @@ public:
 	}
 
 private:
-	nois::f32_t GetValue(nois::count_t f) const
-	{
-		return mValues[f];
-	}
-
-private:
-	nois::count_t mNumFrames;
-	nois::f32_t mSampleRate;
 	nois::FloatRegistry& mRegistry;
-	nois::Ref_t<nois::FloatParameter> mParameter;
+	nois::Ref_t<nois::FloatAutomationParameter> mParameter;
 	std::optional<nois::f32_t> mNextValue;
-	std::vector<nois::f32_t> mValues;
 };
 
 template<typename Param>
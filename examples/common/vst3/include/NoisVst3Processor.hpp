@@ -12,6 +12,9 @@
 
 using namespace Steinberg;
 
+// Sent from processor to controller, which has the host re-read the latency
+inline constexpr FIDString kLatencyChangedMessageId = "NoisLatencyChanged";
+
 template<typename T, typename C>
 class NoisVstProcessor : public Vst::AudioEffect
 {
@@ -26,6 +29,7 @@ public:
 	tresult PLUGIN_API getState(IBStream* state) SMTG_OVERRIDE;
 	tresult PLUGIN_API setupProcessing(Vst::ProcessSetup& setup) SMTG_OVERRIDE;
 	tresult PLUGIN_API process(Vst::ProcessData& data) SMTG_OVERRIDE;
+	uint32 PLUGIN_API getLatencySamples() SMTG_OVERRIDE;
 
 protected:
 	template<typename Param>
@@ -39,18 +43,19 @@ protected:
 
 	nois::Ref_t<nois::FloatParameter> GetTempo();
 
+private:
+	void NotifyLatency();
+
 protected:
 	nois::f32_t mSampleRate;
 	nois::f32_t mTempo;
 
 private:
-	nois::FloatBuffer mSourceBuffer;
-	nois::FloatBuffer mSinkBuffer;
-
 	nois::FloatRegistry mRegistry;
 	std::unordered_map<Vst::ParamID, NoisVstProcessorParameter*> mParameters;
+	nois::count_t mLatencyFrames;
 
-	nois::Ref_t<nois::FloatParameter> mTempoParameter;
+	nois::Ref_t<nois::FloatQueueParameter> mTempoParameter;
 	nois::Ref_t<nois::FloatBlockParameter> mTempoBlockParameter;
 };
 
@@ -65,6 +70,7 @@ public:
 
 	tresult PLUGIN_API initialize(FUnknown* context) SMTG_OVERRIDE;
 	tresult PLUGIN_API setComponentState(IBStream* state) SMTG_OVERRIDE;
+	tresult PLUGIN_API notify(Vst::IMessage* message) SMTG_OVERRIDE;
 
 protected:
 	template<typename Param>
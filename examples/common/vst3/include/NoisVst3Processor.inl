@@ -1,9 +1,12 @@
 #include "NoisVst3Processor.hpp"
 
 #include <pluginterfaces/vst/ivstaudioprocessor.h>
+#include <pluginterfaces/vst/ivsteditcontroller.h>
+#include <pluginterfaces/vst/ivstmessage.h>
 #include <pluginterfaces/vst/ivstprocesscontext.h>
 #include <pluginterfaces/vst/ivstparameterchanges.h>
 #include <pluginterfaces/base/ibstream.h>
+#include <pluginterfaces/base/smartpointer.h>
 #include <pluginterfaces/base/ustring.h>
 
 #include <algorithm>
@@ -11,19 +14,14 @@
 template<typename T, typename C>
 NoisVstProcessor<T, C>::NoisVstProcessor()
 	: mSampleRate(0.0f)
-	, mTempo(0.0f)
-	, mSourceBuffer()
-	, mSinkBuffer()
+	, mTempo(120.0f)
 	, mParameters()
+	, mLatencyFrames(0)
 	, mTempoParameter(nullptr)
 {
 	setControllerClass(C::kUid);
 
-	mTempoParameter = mRegistry.CreateBlockBinder(
-		[this]()
-		{
-			return mTempo;
-		});
+	mTempoParameter = mRegistry.CreateQueue(mTempo);
 }
 
 template<typename T, typename C>
@@ -121,24 +119,30 @@ template<typename T, typename C>
 tresult PLUGIN_API NoisVstProcessor<T, C>::setupProcessing(Vst::ProcessSetup& setup)
 {
 	Vst::SpeakerArrangement arrangement;
+	nois::s32_t numSourceChannels = 0;
 
 	if (getBusArrangement(Vst::kInput, 0, arrangement) == kResultTrue)
 	{
-		nois::s32_t numChannels = Vst::SpeakerArr::getChannelCount(arrangement);
-		mSourceBuffer.Reserve(setup.maxSamplesPerBlock, numChannels);
-	}
-
-	if (getBusArrangement(Vst::kOutput, 0, arrangement) == kResultTrue)
-	{
-		nois::s32_t numChannels = Vst::SpeakerArr::getChannelCount(arrangement);
-		mSinkBuffer.Reserve(setup.maxSamplesPerBlock, numChannels);
+		numSourceChannels = Vst::SpeakerArr::getChannelCount(arrangement);
 	}
 
 	mSampleRate = setup.sampleRate;
 
+	// Hosts split blocks freely, prepare once for the largest one
+	mRegistry.PrepareMax(setup.maxSamplesPerBlock, numSourceChannels, mSampleRate);
+
+	NotifyLatency();
+
 	return AudioEffect::setupProcessing(setup);
 }
 
+template<typename T, typename C>
+uint32 PLUGIN_API NoisVstProcessor<T, C>::getLatencySamples()
+{
+	// The registry already lines up its own branches, this is what's left at the sink
+	return static_cast<uint32>(mRegistry.GetLatencyFrames());
+}
+
 template<typename T, typename C>
 tresult PLUGIN_API NoisVstProcessor<T, C>::process(Vst::ProcessData& data)
 {
@@ -150,9 +154,18 @@ tresult PLUGIN_API NoisVstProcessor<T, C>::process(Vst::ProcessData& data)
 		return kResultOk;
 	}
 
-	if (data.processContext)
+	// Only changes go through the queue, a steady tempo costs nothing to render
+	// Compared at the precision it's kept in, so a host's double never looks changed every block.
+	if (data.processContext &&
+		(data.processContext->state & Vst::ProcessContext::kTempoValid))
 	{
-		mTempo = data.processContext->tempo;
+		nois::f32_t tempo = static_cast<nois::f32_t>(data.processContext->tempo);
+
+		if (tempo != mTempo)
+		{
+			mTempo = tempo;
+			mTempoParameter->Push(mTempo);
+		}
 	}
 
 	NOIS_PROFILE_MARK();
@@ -193,9 +206,7 @@ tresult PLUGIN_API NoisVstProcessor<T, C>::process(Vst::ProcessData& data)
 
 				int32 numPoints = queue->getPointCount();
 
-				nois::count_t currentSampleOffset = 0;
-				nois::f32_t currentValue = parameter->GetLastPlain();
-
+				// Each point is one breakpoint, the block is never expanded per sample
 				for (int j = 0; j < numPoints; ++j)
 				{
 					int32 sampleOffset;
@@ -206,35 +217,9 @@ tresult PLUGIN_API NoisVstProcessor<T, C>::process(Vst::ProcessData& data)
 						continue;
 					}
 
-					for (; currentSampleOffset < sampleOffset &&
-						currentSampleOffset < data.numSamples;
-						++currentSampleOffset)
-					{
-						parameter->WritePlain(
-							currentSampleOffset,
-							currentValue);
-					}
-
-					nois::f32_t nextValue =
-						parameter->ToPlain(valueNormalized);
-
-					if (sampleOffset < data.numSamples)
-					{
-						parameter->WritePlain(
-							sampleOffset,
-							nextValue);
-					}
-
-					currentSampleOffset = sampleOffset + 1;
-					currentValue = nextValue;
-				}
-
-				for (; currentSampleOffset < data.numSamples;
-					++currentSampleOffset)
-				{
 					parameter->WritePlain(
-						currentSampleOffset,
-						currentValue);
+						std::min<nois::count_t>(sampleOffset, data.numSamples - 1),
+						parameter->ToPlain(valueNormalized));
 				}
 			}
 		}
@@ -246,36 +231,11 @@ tresult PLUGIN_API NoisVstProcessor<T, C>::process(Vst::ProcessData& data)
 		auto& inSource = data.inputs[0];
 		auto& outSink = data.outputs[0];
 
-		mSourceBuffer.Resize(data.numSamples, inSource.numChannels);
-		mSinkBuffer.Resize(data.numSamples, outSink.numChannels);
-		
-		{
-			NOIS_PROFILE_SCOPE_NAMED("Read from source");
-
-			for (int c = 0; c < inSource.numChannels; ++c)
-			{
-				const float* samples = inSource.channelBuffers32[c];
-				for (int f = 0; f < data.numSamples; ++f)
-				{
-					mSourceBuffer(f, c) = samples[f];
-				}
-			}
-		}
-
-		mRegistry.Run(mSourceBuffer, mSinkBuffer, mSampleRate);
-		
-		{
-			NOIS_PROFILE_SCOPE_NAMED("Write to sink");
-
-			for (int c = 0; c < outSink.numChannels; ++c)
-			{
-				float* samples = outSink.channelBuffers32[c];
-				for (int f = 0; f < data.numSamples; ++f)
-				{
-					samples[f] = mSinkBuffer(f, c);
-				}
-			}
-		}
+		// The host's channel arrays are run on directly, the sink is written straight into them
+		mRegistry.Run(
+			nois::ConstStridedFloatBufferView(inSource.channelBuffers32, data.numSamples, inSource.numChannels),
+			nois::StridedFloatBufferView(outSink.channelBuffers32, data.numSamples, outSink.numChannels),
+			mSampleRate);
 	}
 
 	return kResultOk;
@@ -310,6 +270,26 @@ auto NoisVstProcessor<T, C>::GetTempo() -> nois::Ref_t<nois::FloatParameter>
 	return mTempoParameter;
 }
 
+template<typename T, typename C>
+void NoisVstProcessor<T, C>::NotifyLatency()
+{
+	// Only the controller can restart the component, tell it when the committed graph lags differently
+	nois::count_t latencyFrames = mRegistry.GetLatencyFrames();
+
+	if (latencyFrames == mLatencyFrames)
+	{
+		return;
+	}
+
+	mLatencyFrames = latencyFrames;
+
+	if (IPtr<Vst::IMessage> message = owned(allocateMessage()))
+	{
+		message->setMessageID(kLatencyChangedMessageId);
+		sendMessage(message);
+	}
+}
+
 template<typename T>
 NoisVstController<T>::NoisVstController()
 	: mParameters()
@@ -379,6 +359,22 @@ tresult PLUGIN_API NoisVstController<T>::setComponentState(IBStream* state)
 	return kResultOk;
 }
 
+template<typename T>
+tresult PLUGIN_API NoisVstController<T>::notify(Vst::IMessage* message)
+{
+	if (message && FIDStringsEqual(message->getMessageID(), kLatencyChangedMessageId))
+	{
+		if (Vst::IComponentHandler* handler = getComponentHandler())
+		{
+			handler->restartComponent(Vst::kLatencyChanged);
+		}
+
+		return kResultOk;
+	}
+
+	return EditController::notify(message);
+}
+
 template<typename T>
 template<typename Param>
 auto NoisVstController<T>::CreateParameter() -> nois::Own_t<NoisVstControllerParameter>
@@ -10,9 +10,6 @@ static uint8_t DSY_SDRAM_BSS sdramHeap[32 * 1024 * 1024];
 void* UMM_MALLOC_CFG_HEAP_ADDR = &sdramHeap;
 size_t UMM_MALLOC_CFG_HEAP_SIZE = sizeof(sdramHeap);
 
-static float scratchIn[2 * 128];
-static float scratchOut[2 * 128];
-
 static float timeSec = 0.0f;
 
 static bool prevGate = false;
@@ -132,23 +129,11 @@ static void callback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out,
 	float grainPhaseIncKnob = hw.GetKnobValue(KNOB_GRAIN_PHASE_INC);
 	grainPhaseIncValue = 2.0f * 2.0f * (grainPhaseIncKnob - 0.5f);
 
-	for (size_t i = 0; i < size; ++i)
-	{
-		scratchIn[i] = IN_L[i];
-		scratchIn[i + size] = IN_R[i];
-	}
-
-	nois::ConstFloatBufferView inView(scratchIn, size, 2);
-	nois::FloatBufferView outView(scratchOut, size, 2);
+	nois::ConstStridedFloatBufferView inView(in, size, 2);
+	nois::StridedFloatBufferView outView(out, size, 2);
 
 	registry->Run(inView, outView, hw.AudioSampleRate());
 
-	for (size_t i = 0; i < size; ++i)
-	{
-		OUT_L[i] = scratchOut[i];
-		OUT_R[i] = scratchOut[i + size];
-	}
-
 	timeSec += deltaSec;
 }
 
@@ -212,6 +197,8 @@ int main(void)
 	timeStretcher->SetGrainBlend(grainBlend);
 	timeStretcher->SetGrainPhaseInc(grainPhaseInc);
 
+	registry->PrepareMax(hw.AudioBlockSize(), 2, hw.AudioSampleRate());
+
 	hw.StartAudio(callback);
 
 	while (true)
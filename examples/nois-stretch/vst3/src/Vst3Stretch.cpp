@@ -182,17 +182,9 @@ public:
 				*mStretchLength);
 
 		auto grainSize =
-			(*mGrainSize)->Transform(
-				[this](nois::f32_t x)
-				{
-					return (x / 1000.0f) * mSampleRate;
-				});
+			(*mGrainSize)->TransformBlock(nois::mapping::MsToFrames{});
 		auto grainBlendNormalized =
-			(*mGrainBlend)->Transform(
-				[](nois::f32_t x)
-				{
-					return x / 2.0f;
-				});
+			(*mGrainBlend)->TransformBlock(nois::mapping::ScaleOffset{ 0.5f, 0.0f });
 
 		mTimeStretcher = CreateStream<nois::TimeStretcher>();
 		mTimeStretcher->SetStretchTimeMs(stretchTimeMs);
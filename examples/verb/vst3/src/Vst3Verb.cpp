@@ -97,11 +97,7 @@ public:
 		mDecayMs = CreateParameter<parameter::DecayMs>();
 
 		auto wetNormalized =
-			mWet->TransformBlock(
-				[](nois::f32_t x)
-				{
-					return x / 100.0f;
-				});
+			(*mWet)->TransformBlock(nois::mapping::ScaleOffset{ 0.01f, 0.0f });
 		
 		mReverb = nois::Reverb::Create();
 		mReverb->SetWet(wetNormalized);
@@ -8,6 +8,9 @@
 #include "analysis/NoisFilterBank.hpp"
 
 #include "core/NoisBuffer.hpp"
+#include "core/NoisExecutor.hpp"
+#include "core/NoisExpression.hpp"
+#include "core/NoisKernels.hpp"
 #include "core/NoisParameter.hpp"
 #include "core/NoisRegistry.hpp"
 #include "core/NoisStream.hpp"
@@ -34,4 +37,7 @@
 #include "route/NoisCombiner.hpp"
 
 #include "util/NoisDelay.hpp"
+#include "util/NoisMappings.hpp"
 #include "util/NoisSmallVector.hpp"
+#include "util/NoisSmoothingBank.hpp"
+#include "util/NoisSpscQueue.hpp"
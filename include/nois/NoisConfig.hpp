@@ -7,11 +7,9 @@ namespace nois {
 // Size of a cache line
 //
 // We use this to align data for faster access.
-#ifndef __cpp_lib_hardware_interference_size
+// Fixed like k_SimdAlignment, std::hardware_destructive_interference_size can change
+// with compiler flags and GCC warns in every header that uses it.
 constexpr std::size_t kCacheLineSize = 64;
-#else
-constexpr std::size_t kCacheLineSize = std::hardware_destructive_interference_size;
-#endif
 
 // Max number of supported channels
 //
@@ -25,4 +23,10 @@ constexpr count_t k_MaxChannels = 2;
 // Using buffer sizes equal or less than give faster access.
 constexpr count_t k_MaxNumInplaceFrames = 128;
 
+// Alignment of dense sample arrays
+//
+// A cache line, and as wide as an AVX-512 vector. Kernels still load unaligned since
+// views and slices start anywhere, aligned storage only keeps those loads on one line.
+constexpr std::size_t k_SimdAlignment = 64;
+
 }
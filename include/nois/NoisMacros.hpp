@@ -65,6 +65,18 @@
 	private: \
 	Own_t<Impl> m_Impl;
 
+#define NOIS_INTERFACE_INPLACE() \
+	public: \
+	bool SupportsInPlace() const override final { return true; }
+
+#define NOIS_INTERFACE_TAIL() \
+	public: \
+	count_t GetTailFrames() const override final;
+
+#define NOIS_INTERFACE_NO_TAIL() \
+	public: \
+	count_t GetTailFrames() const override final { return 0; }
+
 #define NOIS_INTERFACE_PARAM(_name, _type) \
 	public: \
 	void Set##_name(Ref_t<_type> value);
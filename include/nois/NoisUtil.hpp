@@ -3,6 +3,7 @@
 #include "NoisTypes.hpp"
 
 #include <cmath>
+#include <thread>
 
 #if NOIS_ARCH_X64
 #include <xmmintrin.h>
@@ -26,6 +27,18 @@ inline T FastTanh(T x)
 	return x * (T{ 27.0 } + x * x) / (T{ 27.0 } + T{ 9.0 } * x * x);
 }
 
+// Spin wait hint, lets the other hyperthread run while waiting on another core
+inline void CpuRelax()
+{
+#if NOIS_ARCH_X64
+	_mm_pause();
+#elif NOIS_ARCH_ARM64 || NOIS_ARCH_ARM32
+	asm volatile("yield");
+#else
+	std::this_thread::yield();
+#endif // NOIS_ARCH_X64 + NOIS_ARCH_ARM64 + NOIS_ARCH_ARM32
+}
+
 class ScopedNoDenorms
 {
 public:
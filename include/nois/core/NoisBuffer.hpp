@@ -1,6 +1,7 @@
 #pragma once
 
 #include "nois/NoisTypes.hpp"
+#include "nois/core/NoisKernels.hpp"
 #include "nois/core/NoisParameter.hpp"
 #include "nois/math/NoisMatrix.hpp"
 #include "nois/memory/NoisAllocator.hpp"
@@ -41,10 +42,14 @@ template<typename>
 class BufferView;
 template<typename T>
 using ConstBufferView = BufferView<const T>;
+template<typename>
+class StridedBufferView;
 
 using FloatBuffer = Buffer<f32_t>;
 using FloatBufferView = BufferView<f32_t>;
 using ConstFloatBufferView = ConstBufferView<f32_t>;
+using StridedFloatBufferView = StridedBufferView<f32_t>;
+using ConstStridedFloatBufferView = StridedBufferView<const f32_t>;
 
 template<typename T>
 class Buffer
@@ -80,6 +85,11 @@ public:
 		return m_Size == 0;
 	}
 
+	bool IsSilent() const
+	{
+		return std::all_of(m_Data.data(), m_Data.data() + m_Size, [](T sample) { return sample == T{ 0 }; });
+	}
+
 	count_t GetSize() const
 	{
 		return m_Size;
@@ -175,6 +185,23 @@ public:
 		m_Data = std::move(newData);
 	}
 
+	// Changes the shape without reallocating as long as the samples fit what's allocated
+	// Samples aren't moved, so only use it on buffers that are about to be overwritten.
+	void Reshape(count_t numFrames, count_t numChannels)
+	{
+		count_t size = numFrames * numChannels;
+
+		if (size > static_cast<count_t>(m_Data.size()))
+		{
+			Resize(numFrames, numChannels);
+			return;
+		}
+
+		m_Size = size;
+		m_NumFrames = numFrames;
+		m_NumChannels = numChannels;
+	}
+
 	void Extend(count_t numCopies, count_t channelCount = 0)
 	{
 		if (numCopies <= 1)
@@ -228,68 +255,40 @@ public:
 
 	void Add(const Buffer<T>& buffer)
 	{
-		// TODO: vectorize
-
-		for (count_t i = 0; i < std::min(m_Size, buffer.GetSize()); ++i)
-		{
-			m_Data[i] += buffer[i];
-		}
+		kernel::Add(m_Data.data(), buffer.Data(), std::min(m_Size, buffer.GetSize()));
 	}
 
 	void Add(const BufferView<T>& buffer)
 	{
-		// TODO: vectorize
-
-		for (count_t i = 0; i < std::min(m_Size, buffer.GetSize()); ++i)
-		{
-			m_Data[i] += buffer[i];
-		}
+		kernel::Add(m_Data.data(), buffer.Data(), std::min(m_Size, buffer.GetSize()));
 	}
 
 	void AddLinearily(const BufferView<T>& buffer1, const BufferView<T>& buffer2, T factor)
 	{
-		// TODO: vectorize
+		kernel::AddMix(m_Data.data(), buffer1.Data(), buffer2.Data(), factor, std::min({ m_Size, buffer1.GetSize(), buffer2.GetSize() }));
+	}
 
-		for (count_t i = 0; i < std::min({ m_Size, buffer1.GetSize(), buffer2.GetSize() }); ++i)
-		{
-			m_Data[i] += buffer1[i] * factor + buffer2[i] * (T{ 1 } - factor);
-		}
+	// Overwrites with the sum of two buffers
+	// Used to mix fan-in without zeroing first.
+	void Sum(const Buffer<T>& buffer1, const Buffer<T>& buffer2)
+	{
+		kernel::Sum(m_Data.data(), buffer1.Data(), buffer2.Data(), std::min({ m_Size, buffer1.GetSize(), buffer2.GetSize() }));
 	}
 
 	void Subtract(const Buffer<T>& buffer)
 	{
-		// TODO: vectorize
-
-		for (count_t i = 0; i < std::min(m_Size, buffer.GetSize()); ++i)
-		{
-			m_Data[i] -= buffer[i];
-		}
+		kernel::Subtract(m_Data.data(), buffer.Data(), std::min(m_Size, buffer.GetSize()));
 	}
 
 	void Multiply(T value)
 	{
-		// TODO: vectorize
-
-		for (count_t i = 0; i < m_Size; ++i)
-		{
-			m_Data[i] *= value;
-		}
+		kernel::Scale(m_Data.data(), m_Data.data(), value, m_Size);
 	}
 
-	void Multiply(const SlotParameter<T>& parameter)
+	// Picks a kernel from the shape of the block, see BufferView::Multiply()
+	void Multiply(const BlockSpan<T>& span)
 	{
-		// TODO: vectorize
-		// TODO: how can we validate size of parameters?
-
-		auto parameterBlock = parameter.Get();
-		for (count_t f = 0; f < m_NumFrames; ++f)
-		{
-			T value = parameterBlock.Get(f);
-			for (count_t c = 0; c < m_NumChannels; ++c)
-			{
-				(*this)(f, c) *= value;
-			}
-		}
+		BufferView<T>(*this).Multiply(span);
 	}
 
 	void Multiply(const math::Mat<T>& mat)
@@ -384,6 +383,11 @@ public:
 		return m_Size == 0;
 	}
 
+	bool IsSilent() const
+	{
+		return std::all_of(m_Data, m_Data + m_Size, [](T sample) { return sample == T{ 0 }; });
+	}
+
 	count_t GetSize() const
 	{
 		return m_Size;
@@ -449,44 +453,24 @@ public:
 
 	void Copy(const BufferView<T>& buffer, T factor)
 	{
-		// TODO: vectorize
-
-		for (count_t i = 0; i < std::min(m_Size, buffer.GetSize()); ++i)
-		{
-			m_Data[i] = buffer[i] * factor;
-		}
+		kernel::Scale(m_Data, buffer.Data(), factor, std::min(m_Size, buffer.GetSize()));
 	}
 
 	template<typename U = T>
 	auto Copy(const ConstBufferView<T>& buffer, T factor) -> std::enable_if_t<!std::is_const_v<U>>
 	{
-		// TODO: vectorize
-
-		for (count_t i = 0; i < std::min(m_Size, buffer.GetSize()); ++i)
-		{
-			m_Data[i] = buffer[i] * factor;
-		}
+		kernel::Scale(m_Data, buffer.Data(), factor, std::min(m_Size, buffer.GetSize()));
 	}
 
 	void CopyLinearily(const BufferView<T>& buffer, T factor)
 	{
-		// TODO: vectorize
-
-		for (count_t i = 0; i < std::min(m_Size, buffer.GetSize()); ++i)
-		{
-			m_Data[i] = m_Data[i] * factor + buffer[i] * (T{ 1 } - factor);
-		}
+		kernel::Mix(m_Data, m_Data, buffer.Data(), factor, std::min(m_Size, buffer.GetSize()));
 	}
 
 	template<typename U = T>
 	auto CopyLinearily(const ConstBufferView<T>& buffer, T factor) -> std::enable_if_t<!std::is_const_v<U>>
 	{
-		// TODO: vectorize
-
-		for (count_t i = 0; i < std::min(m_Size, buffer.GetSize()); ++i)
-		{
-			m_Data[i] = m_Data[i] * factor + buffer[i] * (T{ 1 } - factor);
-		}
+		kernel::Mix(m_Data, m_Data, buffer.Data(), factor, std::min(m_Size, buffer.GetSize()));
 	}
 
 	Buffer<T> Take(count_t c, count_t numChannels = 1) const
@@ -518,77 +502,86 @@ public:
 
 	void Add(const Buffer<T>& buffer)
 	{
-		// TODO: vectorize
-
-		for (count_t i = 0; i < std::min(m_Size, buffer.GetSize()); ++i)
-		{
-			m_Data[i] += buffer[i];
-		}
+		kernel::Add(m_Data, buffer.Data(), std::min(m_Size, buffer.GetSize()));
 	}
 
 	void Add(const BufferView<T>& buffer)
 	{
-		// TODO: vectorize
-
-		for (count_t i = 0; i < std::min(m_Size, buffer.GetSize()); ++i)
-		{
-			m_Data[i] += buffer[i];
-		}
+		kernel::Add(m_Data, buffer.Data(), std::min(m_Size, buffer.GetSize()));
 	}
 
 	void Add(const BufferView<T>& buffer, T factor)
 	{
-		// TODO: vectorize
-
-		for (count_t i = 0; i < std::min(m_Size, buffer.GetSize()); ++i)
-		{
-			m_Data[i] += buffer[i] * factor;
-		}
+		kernel::AddScaled(m_Data, buffer.Data(), factor, std::min(m_Size, buffer.GetSize()));
 	}
 
 	void AddLinearily(const BufferView<T>& buffer1, const BufferView<T>& buffer2, T factor)
 	{
-		// TODO: vectorize
-
-		for (count_t i = 0; i < std::min({ m_Size, buffer1.GetSize(), buffer2.GetSize() }); ++i)
-		{
-			m_Data[i] += buffer1[i] * factor + buffer2[i] * (T{ 1 } - factor);
-		}
+		kernel::AddMix(m_Data, buffer1.Data(), buffer2.Data(), factor, std::min({ m_Size, buffer1.GetSize(), buffer2.GetSize() }));
 	}
 
 	void Subtract(const BufferView<T>& buffer)
 	{
-		// TODO: vectorize
-
-		for (count_t i = 0; i < std::min(m_Size, buffer.GetSize()); ++i)
-		{
-			m_Data[i] -= buffer[i];
-		}
+		kernel::Subtract(m_Data, buffer.Data(), std::min(m_Size, buffer.GetSize()));
 	}
 
 	void Multiply(T value)
 	{
-		// TODO: vectorize
+		kernel::Scale(m_Data, m_Data, value, m_Size);
+	}
+
+	// Picks a kernel from the shape of the block
+	// Constant blocks broadcast, ramps are generated on the fly, anything else is read per frame.
+	void Multiply(const BlockSpan<T>& span)
+	{
+		count_t numFrames = std::min(m_NumFrames, span.IsConstant() ? m_NumFrames : span.numFrames);
 
-		for (count_t i = 0; i < m_Size; ++i)
+		switch (span.shape)
 		{
-			m_Data[i] *= value;
+		case BlockShape::Constant:
+		{
+			Multiply(span.values[0]);
+			break;
 		}
-	}
+		case BlockShape::Linear:
+		{
+			T first = span.values[0];
+			T step = span.step;
 
-	void Multiply(SlotParameter<T>& parameter)
-	{
-		// TODO: vectorize
-		// TODO: how can we validate size of parameters?
+			for (count_t c = 0; c < m_NumChannels; ++c)
+			{
+				T* samples = m_Data + c * m_NumFrames;
 
-		auto parameterBlock = parameter.Get();
-		for (count_t f = 0; f < m_NumFrames; ++f)
+				for (count_t f = 0; f < numFrames; ++f)
+				{
+					samples[f] *= first + static_cast<T>(f) * step;
+				}
+			}
+			break;
+		}
+		case BlockShape::Arbitrary:
 		{
-			T value = parameterBlock.Get(f);
+			const T* values = span.values;
+
 			for (count_t c = 0; c < m_NumChannels; ++c)
 			{
-				(*this)(f, c) *= value;
+				T* samples = m_Data + c * m_NumFrames;
+
+				// Interleaved sources like SmoothingBank hand out strided spans
+				if (span.stride == 1)
+				{
+					kernel::Multiply(samples, values, numFrames);
+				}
+				else
+				{
+					for (count_t f = 0; f < numFrames; ++f)
+					{
+						samples[f] *= span[f];
+					}
+				}
 			}
+			break;
+		}
 		}
 	}
 
@@ -672,4 +665,219 @@ private:
 	T* m_Data;
 };
 
+// Strided buffer view
+// Samples in memory the graph doesn't own, like a host's, in the layout they come in:
+// planar, interleaved or an array per channel. Sample (f, c) is Channel(c)[f * frameStride].
+// Nothing is copied until CopyTo() or CopyFrom() convert to or from a planar buffer.
+template<typename T>
+class StridedBufferView
+{
+public:
+	using Sample = std::remove_const_t<T>;
+
+	StridedBufferView(T* data, count_t numFrames, count_t numChannels, count_t frameStride, count_t channelStride)
+		: m_NumFrames(numFrames)
+		, m_NumChannels(numChannels)
+		, m_FrameStride(frameStride)
+		, m_ChannelStride(channelStride)
+		, m_FrameOffset(0)
+		, m_Data(data)
+		, m_Channels(nullptr)
+	{
+	}
+
+	// One array per channel, as plugin and device APIs hand audio over
+	// The array of pointers isn't copied and has to outlive the view.
+	StridedBufferView(T* const* channels, count_t numFrames, count_t numChannels)
+		: m_NumFrames(numFrames)
+		, m_NumChannels(numChannels)
+		, m_FrameStride(1)
+		, m_ChannelStride(0)
+		, m_FrameOffset(0)
+		, m_Data(nullptr)
+		, m_Channels(channels)
+	{
+	}
+
+	static StridedBufferView Planar(T* data, count_t numFrames, count_t numChannels)
+	{
+		return StridedBufferView(data, numFrames, numChannels, 1, numFrames);
+	}
+
+	static StridedBufferView Interleaved(T* data, count_t numFrames, count_t numChannels)
+	{
+		return StridedBufferView(data, numFrames, numChannels, numChannels, 1);
+	}
+
+	count_t GetNumFrames() const
+	{
+		return m_NumFrames;
+	}
+
+	count_t GetNumChannels() const
+	{
+		return m_NumChannels;
+	}
+
+	count_t GetFrameStride() const
+	{
+		return m_FrameStride;
+	}
+
+	// Laid out like a BufferView, AsPlanar() then views the samples in place
+	bool IsPlanar() const
+	{
+		return !m_Channels && m_FrameStride == 1 && (m_ChannelStride == m_NumFrames || m_NumChannels <= 1);
+	}
+
+	bool IsInterleaved() const
+	{
+		return !m_Channels && m_ChannelStride == 1 && m_FrameStride > 1;
+	}
+
+	// Only valid when IsPlanar()
+	BufferView<T> AsPlanar() const
+	{
+		return BufferView<T>(Channel(0), m_NumFrames, m_NumChannels);
+	}
+
+	// Frames [offset, offset + numFrames) of the same samples
+	StridedBufferView Slice(count_t offset, count_t numFrames) const
+	{
+		StridedBufferView slice = *this;
+		slice.m_FrameOffset += offset;
+		slice.m_NumFrames = std::min(numFrames, m_NumFrames - offset);
+		return slice;
+	}
+
+	T* Channel(count_t c) const
+	{
+		T* channel = m_Channels ? m_Channels[c] : m_Data + c * m_ChannelStride;
+		return channel + m_FrameOffset * m_FrameStride;
+	}
+
+	T& operator()(count_t f, count_t c) const
+	{
+		return Channel(c)[f * m_FrameStride];
+	}
+
+	operator StridedBufferView<const T>() const
+	{
+		StridedBufferView<const T> view(m_Data, m_NumFrames, m_NumChannels, m_FrameStride, m_ChannelStride);
+		view.m_FrameOffset = m_FrameOffset;
+		view.m_Channels = m_Channels;
+		return view;
+	}
+
+	template<typename U = T>
+	auto Zero() const -> std::enable_if_t<!std::is_const_v<U>>
+	{
+		for (count_t c = 0; c < m_NumChannels; ++c)
+		{
+			T* channel = Channel(c);
+
+			for (count_t f = 0; f < m_NumFrames; ++f)
+			{
+				channel[f * m_FrameStride] = Sample{ 0 };
+			}
+		}
+	}
+
+	// Converts into a planar buffer, up to the frames and channels both have
+	void CopyTo(BufferView<Sample> buffer) const
+	{
+		count_t numFrames = std::min(m_NumFrames, buffer.GetNumFrames());
+		count_t numChannels = std::min(m_NumChannels, buffer.GetNumChannels());
+
+		if (numFrames <= 0 || numChannels <= 0)
+		{
+			return;
+		}
+
+		if (m_FrameStride == 1)
+		{
+			for (count_t c = 0; c < numChannels; ++c)
+			{
+				std::copy_n(Channel(c), numFrames, &buffer(0, c));
+			}
+		}
+		else if (IsInterleaved())
+		{
+			kernel::Deinterleave<Sample>(buffer.Data(), buffer.GetNumFrames(), Channel(0), m_FrameStride, numFrames, numChannels);
+		}
+		else
+		{
+			for (count_t c = 0; c < numChannels; ++c)
+			{
+				const T* channel = Channel(c);
+
+				for (count_t f = 0; f < numFrames; ++f)
+				{
+					buffer(f, c) = channel[f * m_FrameStride];
+				}
+			}
+		}
+	}
+
+	// Converts from a planar buffer, frames and channels it doesn't have are zeroed
+	// Host arrays are written in place, so nothing they held before may leak through.
+	template<typename U = T>
+	auto CopyFrom(ConstBufferView<Sample> buffer) const -> std::enable_if_t<!std::is_const_v<U>>
+	{
+		count_t numFrames = std::max<count_t>(std::min(m_NumFrames, buffer.GetNumFrames()), 0);
+		count_t numChannels = std::max<count_t>(std::min(m_NumChannels, buffer.GetNumChannels()), 0);
+
+		for (count_t c = 0; c < m_NumChannels; ++c)
+		{
+			T* channel = Channel(c);
+
+			for (count_t f = c < numChannels ? numFrames : 0; f < m_NumFrames; ++f)
+			{
+				channel[f * m_FrameStride] = Sample{ 0 };
+			}
+		}
+
+		if (numFrames <= 0 || numChannels <= 0)
+		{
+			return;
+		}
+
+		if (m_FrameStride == 1)
+		{
+			for (count_t c = 0; c < numChannels; ++c)
+			{
+				std::copy_n(&buffer(0, c), numFrames, Channel(c));
+			}
+		}
+		else if (IsInterleaved())
+		{
+			kernel::Interleave<Sample>(Channel(0), m_FrameStride, buffer.Data(), buffer.GetNumFrames(), numFrames, numChannels);
+		}
+		else
+		{
+			for (count_t c = 0; c < numChannels; ++c)
+			{
+				T* channel = Channel(c);
+
+				for (count_t f = 0; f < numFrames; ++f)
+				{
+					channel[f * m_FrameStride] = buffer(f, c);
+				}
+			}
+		}
+	}
+
+private:
+	template<typename>
+	friend class StridedBufferView;
+
+	count_t m_NumFrames;
+	count_t m_NumChannels;
+	count_t m_FrameStride;
+	count_t m_ChannelStride;
+	count_t m_FrameOffset;
+	T* m_Data;
+	T* const* m_Channels;
+};
+
 }
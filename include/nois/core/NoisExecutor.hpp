@@ -0,0 +1,55 @@
+#pragma once
+
+#include "nois/NoisTypes.hpp"
+
+namespace nois {
+
+// Work-stealing executor
+// Runs a dependency graph of tasks over a fixed pool of realtime worker threads.
+// The calling thread takes part in the work and Execute() returns when every task has run.
+// One graph runs at a time. An executor shared between registries hands out its workers to
+// whichever calls first, the others are refused and run serially.
+class Executor
+{
+public:
+	class Impl;
+
+	// Graph of tasks to execute
+	// Dependents are stored as compressed rows, finishing task t unlocks
+	// dependents[dependentOffsets[t]] up to dependents[dependentOffsets[t + 1]].
+	struct Graph
+	{
+		count_t numTasks = 0;
+		const count_t* numDependencies = nullptr;
+		const count_t* dependentOffsets = nullptr;
+		const count_t* dependents = nullptr;
+		void (*run)(void* context, count_t task) = nullptr;
+		void* context = nullptr;
+	};
+
+public:
+	Executor(Own_t<Impl> impl);
+	~Executor();
+	Executor(const Executor&) = delete;
+	Executor(Executor&&) noexcept = delete;
+	Executor& operator=(const Executor&) = delete;
+	Executor& operator=(Executor&&) noexcept = delete;
+
+	// Zero workers picks one less than the number of hardware threads
+	static Ref_t<Executor> Create(count_t numWorkers = 0);
+
+	// Allocates queues for graphs of up to numTasks
+	// Waits for a graph still executing, call it from a control thread rather than a realtime one.
+	void Reserve(count_t numTasks);
+
+	// Returns false without running anything when the graph has more tasks than reserved,
+	// or while another thread is executing or reserving
+	bool Execute(const Graph& graph);
+
+	count_t GetNumWorkers() const;
+
+private:
+	Own_t<Impl> m_Impl;
+};
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "nois/NoisTypes.hpp"
+#include "nois/core/NoisParameter.hpp"
+
+#include <string>
+
+namespace nois {
+
+// Expression
+// A small functional language for parameter transforms, parsed once and compiled to
+// register bytecode. The program runs over chunks of a block an instruction at a time,
+// so dispatch is paid per chunk and each op is a tight loop over the chunk.
+//
+//   db(x) * lfo(2hz) + 0.5
+//
+// Inputs are x, y, z and w in the order they're bound, sr is the sample rate and pi is pi.
+// Numbers take hz, khz, s, ms and db suffixes, db converts to a linear gain.
+// Operators are + - * / ^ and unary minus. Functions are db, todb, exp, log, sqrt, abs,
+// sin, cos, tanh, min, max, pow, clamp and the oscillators lfo and saw, which take a
+// frequency. Oscillators keep their phase in the expression, so compile one per use.
+class Expression
+{
+public:
+	class Impl;
+
+	static constexpr count_t k_MaxInputs = 4;
+
+public:
+	Expression(Own_t<Impl> impl);
+	~Expression();
+	Expression(const Expression&) = delete;
+	Expression(Expression&&) noexcept = delete;
+	Expression& operator=(const Expression&) = delete;
+	Expression& operator=(Expression&&) noexcept = delete;
+
+	// Returns nullptr when source doesn't compile, error then says why and where
+	static Ref_t<Expression> Compile(const std::string& source, std::string* error = nullptr);
+
+	count_t GetNumInputs() const;
+
+	// Whether it changes over time on its own, constant inputs don't make it constant then
+	bool IsTimeVarying() const;
+
+	// Renders numFrames into out, inputs holds GetNumInputs() spans
+	void Process(f32_t* out, count_t numFrames, const BlockSpan<f32_t>* inputs, f32_t sampleRate);
+
+private:
+	Own_t<Impl> m_Impl;
+};
+
+// Block transformer running an expression
+// Binds up to Expression::k_MaxInputs parameters, see Registry::CreateExpression().
+struct ExpressionTransformer
+{
+	Ref_t<Expression> expression;
+
+	bool operator==(const ExpressionTransformer&) const = default;
+
+	bool IsTimeVarying() const
+	{
+		return expression->IsTimeVarying();
+	}
+
+	void operator()(f32_t* out, count_t numFrames, f32_t sampleRate)
+	{
+		expression->Process(out, numFrames, nullptr, sampleRate);
+	}
+
+	void operator()(f32_t* out, count_t numFrames, const BlockSpan<f32_t>& x, f32_t sampleRate)
+	{
+		BlockSpan<f32_t> inputs[] = { x };
+		expression->Process(out, numFrames, inputs, sampleRate);
+	}
+
+	void operator()(f32_t* out, count_t numFrames, const BlockSpan<f32_t>& x, const BlockSpan<f32_t>& y, f32_t sampleRate)
+	{
+		BlockSpan<f32_t> inputs[] = { x, y };
+		expression->Process(out, numFrames, inputs, sampleRate);
+	}
+
+	void operator()(f32_t* out, count_t numFrames, const BlockSpan<f32_t>& x, const BlockSpan<f32_t>& y, const BlockSpan<f32_t>& z, f32_t sampleRate)
+	{
+		BlockSpan<f32_t> inputs[] = { x, y, z };
+		expression->Process(out, numFrames, inputs, sampleRate);
+	}
+
+	void operator()(f32_t* out, count_t numFrames, const BlockSpan<f32_t>& x, const BlockSpan<f32_t>& y, const BlockSpan<f32_t>& z, const BlockSpan<f32_t>& w, f32_t sampleRate)
+	{
+		BlockSpan<f32_t> inputs[] = { x, y, z, w };
+		expression->Process(out, numFrames, inputs, sampleRate);
+	}
+};
+
+}
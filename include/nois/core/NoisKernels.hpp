@@ -0,0 +1,241 @@
+#pragma once
+
+#include "nois/NoisTypes.hpp"
+#include "nois/NoisMacros.hpp"
+
+#include <atomic>
+#include <type_traits>
+
+// SIMD kernels
+// The float loops behind Buffer and BufferView arithmetic. Every instruction set gets its
+// own build of the kernels and the widest one the CPU runs is picked once at startup:
+// AVX-512, AVX2 with FMA or SSE2 on x64, NEON on ARM64 and plain loops elsewhere.
+// Outputs may be the very same array as an input, but mustn't partially overlap one.
+namespace nois::kernel {
+
+enum class Isa : uint8_t
+{
+	Scalar,
+	Sse2,
+	Avx2,
+	Avx512,
+	Neon
+};
+
+struct Table
+{
+	Isa isa = Isa::Scalar;
+	// out[i] += in[i]
+	void (*add)(f32_t* out, const f32_t* in, count_t size) = nullptr;
+	// out[i] = in1[i] + in2[i]
+	void (*sum)(f32_t* out, const f32_t* in1, const f32_t* in2, count_t size) = nullptr;
+	// out[i] -= in[i]
+	void (*subtract)(f32_t* out, const f32_t* in, count_t size) = nullptr;
+	// out[i] *= in[i]
+	void (*multiply)(f32_t* out, const f32_t* in, count_t size) = nullptr;
+	// out[i] += in[i] * factor
+	void (*addScaled)(f32_t* out, const f32_t* in, f32_t factor, count_t size) = nullptr;
+	// out[i] = in[i] * factor
+	void (*scale)(f32_t* out, const f32_t* in, f32_t factor, count_t size) = nullptr;
+	// out[i] = in1[i] * factor + in2[i] * (1 - factor)
+	void (*mix)(f32_t* out, const f32_t* in1, const f32_t* in2, f32_t factor, count_t size) = nullptr;
+	// out[i] += in1[i] * factor + in2[i] * (1 - factor)
+	void (*addMix)(f32_t* out, const f32_t* in1, const f32_t* in2, f32_t factor, count_t size) = nullptr;
+	// out[c * outChannelStride + f] = in[f * inFrameStride + c]
+	void (*deinterleave)(f32_t* out, count_t outChannelStride, const f32_t* in, count_t inFrameStride, count_t numFrames, count_t numChannels) = nullptr;
+	// out[f * outFrameStride + c] = in[c * inChannelStride + f]
+	void (*interleave)(f32_t* out, count_t outFrameStride, const f32_t* in, count_t inChannelStride, count_t numFrames, count_t numChannels) = nullptr;
+};
+
+namespace detail {
+
+extern std::atomic<const Table*> g_Table;
+
+}
+
+// Kernels in use, plain loops until static initialization has detected the CPU
+inline const Table& Get()
+{
+	return *detail::g_Table.load(std::memory_order_relaxed);
+}
+
+// Widest instruction set this CPU and build support
+Isa GetBestIsa();
+
+// Switches every kernel to isa, for tests and benchmarks
+// Returns false and keeps the current kernels when the CPU can't run it.
+bool Select(Isa isa);
+
+const char* GetName(Isa isa);
+
+// Sample types other than f32_t take the plain loops below
+
+template<typename T>
+inline void Add(T* out, const T* in, count_t size)
+{
+	if constexpr (std::is_same_v<T, f32_t>)
+	{
+		Get().add(out, in, size);
+	}
+	else
+	{
+		for (count_t i = 0; i < size; ++i)
+		{
+			out[i] += in[i];
+		}
+	}
+}
+
+template<typename T>
+inline void Sum(T* out, const T* in1, const T* in2, count_t size)
+{
+	if constexpr (std::is_same_v<T, f32_t>)
+	{
+		Get().sum(out, in1, in2, size);
+	}
+	else
+	{
+		for (count_t i = 0; i < size; ++i)
+		{
+			out[i] = in1[i] + in2[i];
+		}
+	}
+}
+
+template<typename T>
+inline void Subtract(T* out, const T* in, count_t size)
+{
+	if constexpr (std::is_same_v<T, f32_t>)
+	{
+		Get().subtract(out, in, size);
+	}
+	else
+	{
+		for (count_t i = 0; i < size; ++i)
+		{
+			out[i] -= in[i];
+		}
+	}
+}
+
+template<typename T>
+inline void Multiply(T* out, const T* in, count_t size)
+{
+	if constexpr (std::is_same_v<T, f32_t>)
+	{
+		Get().multiply(out, in, size);
+	}
+	else
+	{
+		for (count_t i = 0; i < size; ++i)
+		{
+			out[i] *= in[i];
+		}
+	}
+}
+
+template<typename T>
+inline void AddScaled(T* out, const T* in, T factor, count_t size)
+{
+	if constexpr (std::is_same_v<T, f32_t>)
+	{
+		Get().addScaled(out, in, factor, size);
+	}
+	else
+	{
+		for (count_t i = 0; i < size; ++i)
+		{
+			out[i] += in[i] * factor;
+		}
+	}
+}
+
+template<typename T>
+inline void Scale(T* out, const T* in, T factor, count_t size)
+{
+	if constexpr (std::is_same_v<T, f32_t>)
+	{
+		Get().scale(out, in, factor, size);
+	}
+	else
+	{
+		for (count_t i = 0; i < size; ++i)
+		{
+			out[i] = in[i] * factor;
+		}
+	}
+}
+
+template<typename T>
+inline void Mix(T* out, const T* in1, const T* in2, T factor, count_t size)
+{
+	if constexpr (std::is_same_v<T, f32_t>)
+	{
+		Get().mix(out, in1, in2, factor, size);
+	}
+	else
+	{
+		for (count_t i = 0; i < size; ++i)
+		{
+			out[i] = in1[i] * factor + in2[i] * (T{ 1 } - factor);
+		}
+	}
+}
+
+template<typename T>
+inline void AddMix(T* out, const T* in1, const T* in2, T factor, count_t size)
+{
+	if constexpr (std::is_same_v<T, f32_t>)
+	{
+		Get().addMix(out, in1, in2, factor, size);
+	}
+	else
+	{
+		for (count_t i = 0; i < size; ++i)
+		{
+			out[i] += in1[i] * factor + in2[i] * (T{ 1 } - factor);
+		}
+	}
+}
+
+// Interleaved frames to planar channels
+template<typename T>
+inline void Deinterleave(T* out, count_t outChannelStride, const T* in, count_t inFrameStride, count_t numFrames, count_t numChannels)
+{
+	if constexpr (std::is_same_v<T, f32_t>)
+	{
+		Get().deinterleave(out, outChannelStride, in, inFrameStride, numFrames, numChannels);
+	}
+	else
+	{
+		for (count_t c = 0; c < numChannels; ++c)
+		{
+			for (count_t f = 0; f < numFrames; ++f)
+			{
+				out[c * outChannelStride + f] = in[f * inFrameStride + c];
+			}
+		}
+	}
+}
+
+// Planar channels to interleaved frames
+template<typename T>
+inline void Interleave(T* out, count_t outFrameStride, const T* in, count_t inChannelStride, count_t numFrames, count_t numChannels)
+{
+	if constexpr (std::is_same_v<T, f32_t>)
+	{
+		Get().interleave(out, outFrameStride, in, inChannelStride, numFrames, numChannels);
+	}
+	else
+	{
+		for (count_t c = 0; c < numChannels; ++c)
+		{
+			for (count_t f = 0; f < numFrames; ++f)
+			{
+				out[f * outFrameStride + c] = in[c * inChannelStride + f];
+			}
+		}
+	}
+}
+
+}
@@ -1,8 +1,20 @@
 #pragma once
 
 #include "nois/NoisTypes.hpp"
+#include "nois/NoisConfig.hpp"
+#include "nois/NoisUtil.hpp"
+#include "nois/memory/NoisAllocator.hpp"
+#include "nois/util/NoisSpscQueue.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -15,11 +27,17 @@ template<typename T>
 class Parameter;
 template<typename T, typename F, typename... Params>
 class TransformerParameter;
+template<typename T, typename F, typename... Params>
+class BlockTransformerParameter;
 
 template<typename T>
 class SampleParameter;
 template<typename T, typename F>
 class BinderSampleParameter;
+template<typename T>
+class QueueParameter;
+template<typename T>
+class AutomationParameter;
 
 template<typename T>
 class BlockParameter;
@@ -29,10 +47,12 @@ template<typename T, typename F>
 class BinderBlockParameter;
 
 template<typename T>
-class SlotParameter;
+class ParameterSlot;
 
 using FloatParameter = Parameter<f32_t>;
 using FloatSampleParameter = SampleParameter<f32_t>;
+using FloatQueueParameter = QueueParameter<f32_t>;
+using FloatAutomationParameter = AutomationParameter<f32_t>;
 using FloatBlockParameter = BlockParameter<f32_t>;
 
 // Stream reader
@@ -104,6 +124,215 @@ private:
 	bool m_Initialized = false;
 };
 
+// Bits of a change set
+// Bit f is set when frame f differs from the frame before it.
+constexpr count_t k_ChangeBitsPerWord = 64;
+
+inline bool IsChangeSet(const u64_t* changes, count_t f)
+{
+	return ((changes[f / k_ChangeBitsPerWord] >> (f % k_ChangeBitsPerWord)) & 1) != 0;
+}
+
+// How values move over a block
+// Lets streams pick a broadcast, ramp or per-sample kernel.
+enum class BlockShape : uint8_t
+{
+	Constant,
+	// Every value is values[0] + f * step
+	Linear,
+	Arbitrary
+};
+
+// Span over a whole block
+// Constant blocks have a stride of zero, so they can be hoisted out of loops
+// while indexing still works the same for every frame.
+template<typename T>
+struct BlockSpan
+{
+	const T* values = nullptr;
+	count_t stride = 0;
+	count_t numFrames = 0;
+	// Whether any value changed since the previous block
+	bool changed = false;
+	// Change bits when the source tracks them per frame
+	const u64_t* changes = nullptr;
+	BlockShape shape = BlockShape::Constant;
+	T step = T{ 0 };
+
+	inline bool IsConstant() const { return stride == 0; }
+
+	inline T operator[](count_t f) const { return values[f * stride]; }
+
+	// First frame at or after f whose value changed, numFrames when none did
+	// Spans without change bits can only have changed at the first frame.
+	count_t NextChange(count_t f) const
+	{
+		if (!changes)
+		{
+			return changed && f == 0 ? 0 : numFrames;
+		}
+
+		while (f < numFrames)
+		{
+			count_t word = f / k_ChangeBitsPerWord;
+
+			if (u64_t bits = changes[word] >> (f % k_ChangeBitsPerWord))
+			{
+				return f + static_cast<count_t>(std::countr_zero(bits));
+			}
+
+			f = (word + 1) * k_ChangeBitsPerWord;
+		}
+
+		return numFrames;
+	}
+};
+
+// Values a parameter rendered for the current block
+// Values are dense and aligned so rendering and reading them can vectorize,
+// changes are kept as one bit per frame. Readers point at it, so they always
+// see the block that was rendered last.
+template<typename T>
+struct BlockValues
+{
+	std::vector<T, AlignedAllocator<T, k_SimdAlignment>> values;
+	std::vector<u64_t> changes;
+	count_t numFrames = 0;
+	bool isConstant = true;
+	bool isChanged = false;
+	BlockShape shape = BlockShape::Constant;
+	T step = T{ 0 };
+	T lastValue = T{ 0 };
+	// Whether lastValue came from a rendered block
+	bool isPrimed = false;
+
+	void Prepare(count_t maxFrames)
+	{
+		values.resize(maxFrames);
+		changes.resize((maxFrames + k_ChangeBitsPerWord - 1) / k_ChangeBitsPerWord);
+	}
+
+	// Derives the change bits once values are written for the block
+	void Analyze(count_t numFrames)
+	{
+		this->numFrames = numFrames;
+
+		if (numFrames <= 0)
+		{
+			isConstant = true;
+			isChanged = false;
+			shape = BlockShape::Constant;
+			return;
+		}
+
+		const T* data = values.data();
+		u64_t laterBits = 0;
+		u64_t anyBits = data[0] != lastValue;
+
+		for (count_t begin = 0; begin < numFrames; begin += k_ChangeBitsPerWord)
+		{
+			count_t end = std::min(begin + k_ChangeBitsPerWord, numFrames);
+			u64_t bits = 0;
+
+			for (count_t f = std::max<count_t>(begin, 1); f < end; ++f)
+			{
+				bits |= static_cast<u64_t>(data[f] != data[f - 1]) << (f - begin);
+			}
+
+			laterBits |= bits;
+			changes[begin / k_ChangeBitsPerWord] = bits;
+		}
+
+		changes[0] |= anyBits;
+		isConstant = laterBits == 0;
+		isChanged = (anyBits | laterBits) != 0;
+		lastValue = data[numFrames - 1];
+		isPrimed = true;
+
+		shape = isConstant ? BlockShape::Constant : AnalyzeShape(data, numFrames, step);
+	}
+
+	// Ramps come out of interpolation with rounding, so they're matched within a tolerance
+	static BlockShape AnalyzeShape(const T* data, count_t numFrames, T& step)
+	{
+		if constexpr (std::is_floating_point_v<T>)
+		{
+			T first = data[0];
+			T last = data[numFrames - 1];
+			T tolerance = k_LinearTolerance * std::max({ std::abs(first), std::abs(last), T{ 1 } });
+			T error = T{ 0 };
+
+			step = (last - first) / static_cast<T>(numFrames - 1);
+
+			for (count_t f = 1; f < numFrames - 1; ++f)
+			{
+				error = std::max(error, std::abs(data[f] - (first + static_cast<T>(f) * step)));
+			}
+
+			if (error <= tolerance)
+			{
+				return BlockShape::Linear;
+			}
+		}
+
+		step = T{ 0 };
+		return BlockShape::Arbitrary;
+	}
+
+	static constexpr f32_t k_LinearTolerance = 1e-5f;
+
+	// Evaluates at the last frame of every interval and ramps there from the value before
+	// An interval of zero evaluates once per block, the ramp carries over from the last block.
+	template<typename G>
+	void RenderControlRate(count_t numFrames, count_t interval, G&& evaluate)
+	{
+		T* data = values.data();
+		// Frame the ramp starts from, the last block's final frame sits just before this one
+		count_t anchor = -1;
+		T prev = lastValue;
+
+		if (!isPrimed && numFrames > 0)
+		{
+			anchor = 0;
+			prev = evaluate(0);
+			data[0] = prev;
+		}
+
+		for (count_t begin = 0; begin < numFrames;)
+		{
+			count_t end = interval > 0 ? std::min(begin + interval, numFrames) : numFrames;
+			T next = end - 1 > anchor ? evaluate(end - 1) : prev;
+			T step = (next - prev) / static_cast<T>(std::max<count_t>(end - 1 - anchor, 1));
+
+			for (count_t f = anchor + 1; f < end - 1; ++f)
+			{
+				data[f] = prev + step * static_cast<T>(f - anchor);
+			}
+
+			data[end - 1] = next;
+			anchor = end - 1;
+			prev = next;
+			begin = end;
+		}
+	}
+
+	bool IsChanged(count_t f) const
+	{
+		return IsChangeSet(changes.data(), f);
+	}
+
+	// Unprepared blocks hold the value they started with, never a null span
+	BlockSpan<T> Span() const
+	{
+		if (values.empty())
+		{
+			return { &lastValue, 0, numFrames, false };
+		}
+
+		return { values.data(), isConstant ? 0 : 1, numFrames, isChanged, changes.data(), shape, step };
+	}
+};
+
 // Block reader
 // Can read parameter at any given offset in the block.
 template<typename T>
@@ -125,28 +354,55 @@ public:
 	virtual ~IBlockReader() = default;
 
 	virtual Point Get(count_t f) const = 0;
+
+	// The whole block at once, called once per block instead of per sample
+	virtual BlockSpan<T> Span() = 0;
 };
 
 template<typename T>
 class Parameter : public RefFromThis_t<Parameter<T>>
 {
 	friend class Registry<T>;
+	friend class ParameterSlot<T>;
 
 public:
 	virtual ~Parameter() {}
 
-	// Called when block size or rate changes
-	virtual void Prepare(count_t numFrames, f32_t sampleRate) {}
+	// Called when the maximum block size or rate changes
+	virtual void Prepare(count_t maxFrames, f32_t sampleRate) {}
 	
-	// Called for every block
+	// Called for every block, never with more frames than prepared for
+	virtual void Update(count_t numFrames) { Update(); }
+
+	// Per-block update from before blocks could vary in length, kept for older subclasses
+	// Only reached through the default above, new code overrides Update(numFrames).
 	virtual void Update() {}
 
+	// Called in place of Update() for blocks nothing reads
+	// Parameters fed from other threads drop what the block passed instead of piling it up.
+	virtual void Skip(count_t numFrames) {}
+
 	virtual T Min() const { return T{ 0 }; }
 	virtual T Max() const { return T{ 0 }; }
 
 	virtual Ref_t<IStreamReader<T>> Stream() const = 0;
 	virtual Ref_t<IBlockReader<T>> Block() const = 0;
 
+	// Whether a slot reads it, the registry only evaluates parameters something reads
+	bool IsSlotted() const { return mNumSlots.load(std::memory_order_relaxed) > 0; }
+
+	// Frames between evaluations, interpolated linearly in between
+	// Zero evaluates once per block, one every frame. Per-frame transformers and sample
+	// binders honor it, everything else always renders exactly.
+	static constexpr count_t k_DefaultControlInterval = 1;
+
+	void SetControlInterval(count_t numFrames) { mControlInterval.store(std::max<count_t>(numFrames, 0), std::memory_order_relaxed); }
+	count_t GetControlInterval() const { return mControlInterval.load(std::memory_order_relaxed); }
+
+	// Transformers comparing equal over the same parameter resolve to one shared parameter,
+	// and everyone holding it sees its settings. Only parameters still at the default control
+	// interval are handed out again, so change it right after creating a transform to keep
+	// it to yourself. Lambdas never compare equal and are never shared.
 	template<typename F>
 	Ref_t<Parameter<T>> Transform(F&& transformer)
 	{
@@ -160,151 +416,263 @@ public:
 		return nullptr;
 	}
 
+	// Transforms whole blocks, see BlockTransformerParameter
+	// Shared like Transform().
+	template<typename F>
+	Ref_t<Parameter<T>> TransformBlock(F&& transformer)
+	{
+		if (mRegistry)
+		{
+			return mRegistry->CreateBlockTransformer(
+				std::forward<F>(transformer),
+				this->shared_from_this());
+		}
+
+		return nullptr;
+	}
+
+protected:
+	// Hands out a reader the parameter embeds, sharing its ownership so nothing is allocated
+	Ref_t<IBlockReader<T>> Alias(IBlockReader<T>& reader) const
+	{
+		return Ref_t<IBlockReader<T>>(this->shared_from_this(), &reader);
+	}
+
 private:
 	Registry<T>* mRegistry = nullptr;
+	std::atomic<count_t> mNumSlots = 0;
+	std::atomic<count_t> mControlInterval = k_DefaultControlInterval;
 };
 
 template<typename T, typename F, typename... Params>
 class TransformerParameter : public Parameter<T>
 {
 public:
-	class Reader : public IStreamReader<T>, public IBlockReader<T>
+	// Reads the transformed block like any sample parameter
+	using Reader = typename SampleParameter<T>::Reader;
+
+public:
+	TransformerParameter(F&& transformer, Params&&... transformees)
+		: m_Transformer(std::move(transformer))
+		, m_SampleRate(0.0f)
+		, m_Used({ static_cast<Ref_t<Parameter<T>>>(transformees)... })
+		, m_Readables({ nullptr })
 	{
-	public:
-		struct Frame
-		{
-			T value = T{ 0 };
-			bool changed = false;
-		};
+	}
 
-	public:
-		Reader(const Frame* frames, count_t numFrames)
-			: m_NumFrames(numFrames)
-			, m_FrameOffset(0)
-			, m_Frames(frames)
+	void Prepare(count_t maxFrames, f32_t sampleRate) override final
+	{
+		NOIS_PROFILE_SCOPE();
+		
+		m_Block.Prepare(maxFrames);
+		
+		for (count_t i = 0; i < m_Used.size(); ++i)
 		{
+			m_Readables[i] = m_Used[i]->Block();
 		}
+		
+		m_SampleRate = sampleRate;
+	}
+	
+	void Update(count_t numFrames) override final
+	{
+		NOIS_PROFILE_SCOPE();
 
-		IStreamReader<T>::Point Next() override final
+		T* values = m_Block.values.data();
+		std::array<BlockSpan<T>, sizeof...(Params)> spans;
+		bool isConstant = true;
+
+		for (count_t i = 0; i < spans.size(); ++i)
 		{
-			T value = T{ 0 };
-			bool changed = false;
+			spans[i] = m_Readables[i]->Span();
+			isConstant = isConstant && spans[i].IsConstant();
+		}
 
-			value = m_Frames[m_FrameOffset].value;
-			changed = m_Frames[m_FrameOffset].changed;
-			++m_FrameOffset;
+		count_t interval = this->GetControlInterval();
+		auto evaluate =
+			[&](count_t f)
+			{
+				return InvokeTransformer(spans, f, m_SampleRate, std::make_index_sequence<sizeof...(Params)>{});
+			};
+
+		if (isConstant)
+		{
+			// Constant inputs give a constant output, only run the transformer once
+			T value = evaluate(0);
 
-			if (m_FrameOffset >= m_NumFrames)
+			if (interval == 1 || !m_Block.isPrimed || value == m_Block.lastValue)
 			{
-				m_FrameOffset = 0;
+				std::fill_n(values, numFrames, value);
+			}
+			else
+			{
+				m_Block.RenderControlRate(numFrames, interval, [value](count_t) { return value; });
 			}
-
-			return { value, changed };
 		}
-
-		IBlockReader<T>::Point Get(count_t f) const override final
+		else if (interval != 1)
 		{
-			T value = T{ 0 };
-			bool changed = false;
-
-			if (f < m_NumFrames)
+			m_Block.RenderControlRate(numFrames, interval, evaluate);
+		}
+		else
+		{
+			for (count_t f = 0; f < numFrames; ++f)
 			{
-				value = m_Frames[f].value;
-				changed = m_Frames[f].changed;
+				values[f] = evaluate(f);
 			}
+		}
 
-			return { value, changed };
+		m_Block.Analyze(numFrames);
+	}
+
+	Ref_t<IStreamReader<T>> Stream() const override final
+	{
+		return MakeRef<Reader>(&m_Block);
+	}
+
+	Ref_t<IBlockReader<T>> Block() const override final
+	{
+		return this->Alias(m_BlockReader);
+	}
+
+	const F& GetTransformer() const
+	{
+		return m_Transformer;
+	}
+
+private:
+	template<std::size_t... Is>
+	T InvokeTransformer(const std::array<BlockSpan<T>, sizeof...(Params)>& spans, count_t f, f32_t sampleRate, std::index_sequence<Is...>) const
+	{
+		if constexpr (std::is_invocable_v<
+			F,
+			decltype(spans[Is][f])..., f32_t>)
+		{
+			return std::invoke(
+				m_Transformer,
+				spans[Is][f]..., sampleRate);
 		}
+		else
+		{
+			return std::invoke(
+				m_Transformer,
+				spans[Is][f]...);
+		}
+	}
 
-	private:
-		count_t m_NumFrames;
-		count_t m_FrameOffset;
-		const Frame* m_Frames;
-	};
+private:
+	F m_Transformer;
+	f32_t m_SampleRate;
+	std::array<Ref_t<Parameter<T>>, sizeof...(Params)> m_Used;
+	std::array<Ref_t<IBlockReader<T>>, sizeof...(Params)> m_Readables;
+	BlockValues<T> m_Block;
+	mutable Reader m_BlockReader{ &m_Block };
+};
 
+// Block transformer parameter
+// The transformer is called once per block as transformer(out, numFrames, spans...)
+// and writes every output frame, so it can run a tight or vectorized loop.
+// Constant inputs call it for a single frame and the value is broadcast.
+template<typename T, typename F, typename... Params>
+class BlockTransformerParameter : public Parameter<T>
+{
 public:
-	TransformerParameter(F&& transformer, Params&&... transformees)
+	BlockTransformerParameter(F&& transformer, Params&&... transformees)
 		: m_Transformer(std::move(transformer))
-		, m_NumFrames(0)
 		, m_SampleRate(0.0f)
 		, m_Used({ static_cast<Ref_t<Parameter<T>>>(transformees)... })
-		, m_Readables({ nullptr })
+		, m_Readables{}
 	{
 	}
 
-	void Prepare(count_t numFrames, f32_t sampleRate) override final
+	void Prepare(count_t maxFrames, f32_t sampleRate) override final
 	{
 		NOIS_PROFILE_SCOPE();
 		
-		m_Frames.resize(numFrames);
+		m_Block.Prepare(maxFrames);
 		
 		for (count_t i = 0; i < m_Used.size(); ++i)
 		{
 			m_Readables[i] = m_Used[i]->Block();
 		}
 		
-		m_NumFrames = numFrames;
 		m_SampleRate = sampleRate;
 	}
 	
-	void Update() override final
+	void Update(count_t numFrames) override final
 	{
 		NOIS_PROFILE_SCOPE();
-		
-		for (count_t f = 0; f < m_NumFrames; ++f)
+
+		T* values = m_Block.values.data();
+		std::array<BlockSpan<T>, sizeof...(Params)> spans;
+		bool isConstant = true;
+
+		for (count_t i = 0; i < spans.size(); ++i)
 		{
-			T value = InvokeTransformer(
-				[f](auto& p)
-				{
-					return p->Get(f);
-				},
-				m_SampleRate,
-				std::make_index_sequence<sizeof...(Params)>{});
+			spans[i] = m_Readables[i]->Span();
+			isConstant = isConstant && spans[i].IsConstant();
+		}
+
+		// Transformers with state of their own can move under constant inputs
+		if constexpr (requires { m_Transformer.IsTimeVarying(); })
+		{
+			isConstant = isConstant && !m_Transformer.IsTimeVarying();
+		}
 
-			m_Frames[f].value = value;
-			m_Frames[f].changed = f > 0
-				? value != m_Frames[f - 1].value
-				: value != m_Frames.back().value;
+		if (isConstant && numFrames > 0)
+		{
+			InvokeTransformer(values, 1, spans, std::make_index_sequence<sizeof...(Params)>{});
+			std::fill_n(values + 1, numFrames - 1, values[0]);
+		}
+		else
+		{
+			InvokeTransformer(values, numFrames, spans, std::make_index_sequence<sizeof...(Params)>{});
 		}
+
+		m_Block.Analyze(numFrames);
 	}
 
 	Ref_t<IStreamReader<T>> Stream() const override final
 	{
-		return MakeRef<Reader>(m_Frames.data(), m_Frames.size());
+		return MakeRef<typename SampleParameter<T>::Reader>(&m_Block);
 	}
 
 	Ref_t<IBlockReader<T>> Block() const override final
 	{
-		return MakeRef<Reader>(m_Frames.data(), m_Frames.size());
+		return this->Alias(m_BlockReader);
+	}
+
+	const F& GetTransformer() const
+	{
+		return m_Transformer;
 	}
 
 private:
 	template<std::size_t... Is>
-	T InvokeTransformer(auto getter, f32_t sampleRate, std::index_sequence<Is...>) const
+	void InvokeTransformer(T* values, count_t numFrames, const std::array<BlockSpan<T>, sizeof...(Params)>& spans, std::index_sequence<Is...>)
 	{
 		if constexpr (std::is_invocable_v<
-			F,
-			decltype(std::invoke(getter, m_Readables[Is]))..., f32_t>)
+			F&,
+			T*, count_t, decltype(spans[Is])..., f32_t>)
 		{
-			return std::invoke(
+			std::invoke(
 				m_Transformer,
-				std::invoke(getter, m_Readables[Is])..., sampleRate);
+				values, numFrames, spans[Is]..., m_SampleRate);
 		}
 		else
 		{
-			return std::invoke(
+			std::invoke(
 				m_Transformer,
-				std::invoke(getter, m_Readables[Is])...);
+				values, numFrames, spans[Is]...);
 		}
 	}
 
 private:
 	F m_Transformer;
-	count_t m_NumFrames;
 	f32_t m_SampleRate;
 	std::array<Ref_t<Parameter<T>>, sizeof...(Params)> m_Used;
 	std::array<Ref_t<IBlockReader<T>>, sizeof...(Params)> m_Readables;
-	std::vector<typename Reader::Frame> m_Frames;
+	BlockValues<T> m_Block;
+	mutable typename SampleParameter<T>::Reader m_BlockReader{ &m_Block };
 };
 
 // Sample-accurate parameter
@@ -316,17 +684,10 @@ public:
 	class Reader : public IStreamReader<T>, public IBlockReader<T>
 	{
 	public:
-		struct Frame
-		{
-			T value = T{ 0 };
-			bool changed = false;
-		};
-
-	public:
-		Reader(const Frame* frames, count_t numFrames)
-			: m_NumFrames(numFrames)
-			, m_FrameOffset(0)
-			, m_Frames(frames)
+		// Reads through to the block, which can be shorter than prepared for
+		Reader(const BlockValues<T>* block)
+			: m_FrameOffset(0)
+			, m_Block(block)
 		{
 		}
 
@@ -335,11 +696,11 @@ public:
 			T value = T{ 0 };
 			bool changed = false;
 
-			value = m_Frames[m_FrameOffset].value;
-			changed = m_Frames[m_FrameOffset].changed;
+			value = m_Block->values[m_FrameOffset];
+			changed = m_Block->IsChanged(m_FrameOffset);
 			++m_FrameOffset;
 
-			if (m_FrameOffset >= m_NumFrames)
+			if (m_FrameOffset >= m_Block->numFrames)
 			{
 				m_FrameOffset = 0;
 			}
@@ -352,19 +713,23 @@ public:
 			T value = T{ 0 };
 			bool changed = false;
 
-			if (f < m_NumFrames)
+			if (f < m_Block->numFrames)
 			{
-				value = m_Frames[f].value;
-				changed = m_Frames[f].changed;
+				value = m_Block->values[f];
+				changed = m_Block->IsChanged(f);
 			}
 
 			return { value, changed };
 		}
 
+		BlockSpan<T> Span() override final
+		{
+			return m_Block->Span();
+		}
+
 	private:
-		count_t m_NumFrames;
 		count_t m_FrameOffset;
-		const Frame* m_Frames;
+		const BlockValues<T>* m_Block;
 	};
 };
 
@@ -374,52 +739,500 @@ class BinderSampleParameter : public SampleParameter<T>
 public:
 	BinderSampleParameter(F&& binder)
 		: m_Binder(std::move(binder))
-		, m_NumFrames(0)
 		, m_SampleRate(0.0f)
-		, m_Frames()
+		, m_Block()
 	{
 	}
 
-	void Prepare(count_t numFrames, f32_t sampleRate) override final
+	void Prepare(count_t maxFrames, f32_t sampleRate) override final
 	{
 		NOIS_PROFILE_SCOPE();
 		
-		m_Frames.resize(numFrames);
+		m_Block.Prepare(maxFrames);
 
-		m_NumFrames = numFrames;
 		m_SampleRate = sampleRate;
 	}
 	
-	void Update() override final
+	void Update(count_t numFrames) override final
 	{
 		NOIS_PROFILE_SCOPE();
-		
-		for (count_t f = 0; f < m_NumFrames; ++f)
-		{
-			T value = m_Binder(f);
 
-			m_Frames[f].value = value;
-			m_Frames[f].changed = f > 0
-				? value != m_Frames[f - 1].value
-				: value != m_Frames.back().value;
+		T* values = m_Block.values.data();
+		count_t interval = this->GetControlInterval();
+
+		if (interval != 1)
+		{
+			m_Block.RenderControlRate(numFrames, interval, m_Binder);
 		}
+		else
+		{
+			for (count_t f = 0; f < numFrames; ++f)
+			{
+				values[f] = m_Binder(f);
+			}
+		}
+
+		m_Block.Analyze(numFrames);
 	}
 
 	Ref_t<IStreamReader<T>> Stream() const override final
 	{
-		return MakeRef<typename SampleParameter<T>::Reader>(m_Frames.data(), m_Frames.size());
+		return MakeRef<typename SampleParameter<T>::Reader>(&m_Block);
 	}
 
 	Ref_t<IBlockReader<T>> Block() const override final
 	{
-		return MakeRef<typename SampleParameter<T>::Reader>(m_Frames.data(), m_Frames.size());
+		return this->Alias(m_BlockReader);
 	}
 
 private:
 	F m_Binder;
-	count_t m_NumFrames;
 	f32_t m_SampleRate;
-	std::vector<typename SampleParameter<T>::Reader::Frame> m_Frames;
+	BlockValues<T> m_Block;
+	mutable typename SampleParameter<T>::Reader m_BlockReader{ &m_Block };
+};
+
+// Queued parameter
+// Changes are pushed from one other thread through a wait-free ring and drained at the
+// start of every block, each one holding from its frame on. Later changes at or before the
+// same frame win, so bursts coalesce. Neither side locks or allocates once created.
+template<typename T>
+class QueueParameter : public SampleParameter<T>
+{
+public:
+	struct Change
+	{
+		T value = T{ 0 };
+		// Offset into the block it's drained in, clamped to the block
+		count_t frame = 0;
+	};
+
+	static constexpr count_t k_DefaultCapacity = 1024;
+
+public:
+	QueueParameter(T value, count_t capacity = k_DefaultCapacity)
+		: m_Queue(capacity)
+		, m_Capacity(capacity)
+		, m_Pending()
+		, m_HasPending(false)
+		, m_Value(value)
+		, m_NumSteadyFrames(0)
+		, m_Block()
+	{
+	}
+
+	// Producer side, only ever call from one thread at a time
+	// A full ring holds the change back in place of any older held one and returns false.
+	bool Push(T value, count_t frame = 0)
+	{
+		m_Pending = { value, frame };
+		m_HasPending = true;
+
+		return Flush();
+	}
+
+	// Retries the held back change, producers that go quiet after a full ring call it until true
+	bool Flush()
+	{
+		if (m_HasPending && m_Queue.Push(Change(m_Pending)))
+		{
+			m_HasPending = false;
+		}
+
+		return !m_HasPending;
+	}
+
+	void Prepare(count_t maxFrames, f32_t sampleRate) override final
+	{
+		NOIS_PROFILE_SCOPE();
+
+		m_Block.Prepare(maxFrames);
+		m_NumSteadyFrames = 0;
+	}
+
+	void Update(count_t numFrames) override final
+	{
+		NOIS_PROFILE_SCOPE();
+
+		Change change;
+		bool hasChange = m_Queue.Pop(change);
+
+		// Nothing arrived and the block already holds the value, skip rendering it
+		if (!hasChange && numFrames <= m_NumSteadyFrames)
+		{
+			m_Block.numFrames = numFrames;
+			m_Block.isChanged = false;
+			m_Block.changes[0] = 0;
+			return;
+		}
+
+		T* values = m_Block.values.data();
+		count_t cursor = 0;
+		count_t numDrained = 0;
+
+		// A producer that never pauses is left for the next block past one ring's worth
+		for (; hasChange; hasChange = ++numDrained < m_Capacity && m_Queue.Pop(change))
+		{
+			// Out of order frames can't go back, they apply where the block is at
+			count_t frame = std::clamp<count_t>(change.frame, cursor, std::max<count_t>(numFrames - 1, 0));
+
+			std::fill(values + cursor, values + frame, m_Value);
+			cursor = frame;
+			m_Value = change.value;
+		}
+
+		std::fill(values + cursor, values + numFrames, m_Value);
+
+		m_Block.Analyze(numFrames);
+		m_NumSteadyFrames = m_Block.isConstant ? numFrames : 0;
+	}
+
+	// Keeps only the latest change, so the ring never fills while nothing reads it
+	void Skip(count_t numFrames) override final
+	{
+		Change change;
+		count_t numDrained = 0;
+
+		for (; numDrained < m_Capacity && m_Queue.Pop(change); ++numDrained)
+		{
+			m_Value = change.value;
+		}
+
+		if (numDrained > 0)
+		{
+			m_NumSteadyFrames = 0;
+		}
+	}
+
+	Ref_t<IStreamReader<T>> Stream() const override final
+	{
+		return MakeRef<typename SampleParameter<T>::Reader>(&m_Block);
+	}
+
+	Ref_t<IBlockReader<T>> Block() const override final
+	{
+		return this->Alias(m_BlockReader);
+	}
+
+private:
+	SpscQueue<Change> m_Queue;
+	count_t m_Capacity;
+	// Producer only
+	Change m_Pending;
+	bool m_HasPending;
+	// Audio thread only
+	T m_Value;
+	// Frames at the start of the block known to hold m_Value
+	count_t m_NumSteadyFrames;
+	BlockValues<T> m_Block;
+	mutable typename SampleParameter<T>::Reader m_BlockReader{ &m_Block };
+};
+
+// Automation parameter
+// Holds each block as a few segments between breakpoints instead of a value per frame.
+// Values are only rendered once something asks for a span, consumers that can walk
+// Segments() never need them. Breakpoints are added from the thread running the registry.
+template<typename T>
+class AutomationParameter : public SampleParameter<T>
+{
+public:
+	enum class Ramp : uint8_t
+	{
+		// Jumps to the value at its frame
+		Step,
+		// Ramps from the breakpoint before, reaching the value at its frame
+		Linear
+	};
+
+	struct Breakpoint
+	{
+		count_t frame = 0;
+		T value = T{ 0 };
+		Ramp ramp = Ramp::Step;
+	};
+
+	// Frames [begin, end) hold value + (f - begin) * step
+	struct Segment
+	{
+		count_t begin = 0;
+		count_t end = 0;
+		T value = T{ 0 };
+		T step = T{ 0 };
+	};
+
+	class Reader : public IStreamReader<T>, public IBlockReader<T>
+	{
+	public:
+		Reader(const AutomationParameter<T>* parameter)
+			: m_FrameOffset(0)
+			, m_Parameter(parameter)
+		{
+		}
+
+		IStreamReader<T>::Point Next() override final
+		{
+			auto point = Get(m_FrameOffset);
+
+			if (++m_FrameOffset >= m_Parameter->m_NumFrames)
+			{
+				m_FrameOffset = 0;
+			}
+
+			return { point.Value(), point.Changed() };
+		}
+
+		IBlockReader<T>::Point Get(count_t f) const override final
+		{
+			BlockSpan<T> span = m_Parameter->Render();
+
+			if (f >= span.numFrames)
+			{
+				return { T{ 0 }, false };
+			}
+
+			return { span[f], span.IsConstant() ? f == 0 && span.changed : IsChangeSet(span.changes, f) };
+		}
+
+		BlockSpan<T> Span() override final
+		{
+			return m_Parameter->Render();
+		}
+
+	private:
+		count_t m_FrameOffset;
+		const AutomationParameter<T>* m_Parameter;
+	};
+
+	static constexpr count_t k_DefaultCapacity = 128;
+
+public:
+	AutomationParameter(T value, count_t capacity = k_DefaultCapacity)
+		: m_Value(value)
+		, m_Start(value)
+		, m_Constant(value)
+		, m_NumFrames(0)
+		, m_IsChanged(false)
+		, m_RenderState(k_Rendered)
+	{
+		m_Breakpoints.reserve(capacity);
+		m_Segments.reserve(capacity + 1);
+	}
+
+	// Frames count from the start of the next block and should ascend, later blocks take
+	// whatever lands past it. Returns false without allocating when full.
+	bool Add(count_t frame, T value, Ramp ramp = Ramp::Step)
+	{
+		if (m_Breakpoints.size() == m_Breakpoints.capacity())
+		{
+			return false;
+		}
+
+		m_Breakpoints.push_back({ std::max<count_t>(frame, 0), value, ramp });
+		return true;
+	}
+
+	// Like Add(), but once full the last breakpoint moves here instead
+	// Drops the points in between rather than the final value, for dense host automation.
+	void AddOrReplaceLast(count_t frame, T value, Ramp ramp = Ramp::Step)
+	{
+		if (Add(frame, value, ramp) || m_Breakpoints.empty())
+		{
+			return;
+		}
+
+		m_Breakpoints.back() = { std::max<count_t>(frame, 0), value, ramp };
+	}
+
+	// Value once every breakpoint added so far is reached
+	T GetLastValue() const
+	{
+		return m_Breakpoints.empty() ? m_Value : m_Breakpoints.back().value;
+	}
+
+	// Segments of the current block, in order and covering it
+	std::span<const Segment> Segments() const
+	{
+		return { m_Segments.data(), m_Segments.size() };
+	}
+
+	void Prepare(count_t maxFrames, f32_t sampleRate) override final
+	{
+		NOIS_PROFILE_SCOPE();
+
+		m_Block.Prepare(maxFrames);
+	}
+
+	void Update(count_t numFrames) override final
+	{
+		NOIS_PROFILE_SCOPE();
+
+		T start = m_Value;
+		count_t frame = 0;
+		count_t numUsed = 0;
+
+		m_Segments.clear();
+
+		for (; numUsed < static_cast<count_t>(m_Breakpoints.size()); ++numUsed)
+		{
+			const Breakpoint& breakpoint = m_Breakpoints[numUsed];
+			count_t end = std::max(breakpoint.frame, frame);
+			T step = breakpoint.ramp == Ramp::Linear && end > frame
+				? (breakpoint.value - m_Value) / static_cast<T>(end - frame)
+				: T{ 0 };
+
+			// Past this block, ramp towards it as far as the block goes
+			if (end >= numFrames)
+			{
+				if (frame < numFrames)
+				{
+					m_Segments.push_back({ frame, numFrames, m_Value, step });
+					m_Value += step * static_cast<T>(numFrames - frame);
+					frame = numFrames;
+				}
+
+				break;
+			}
+
+			if (end > frame)
+			{
+				m_Segments.push_back({ frame, end, m_Value, step });
+			}
+
+			frame = end;
+			m_Value = breakpoint.value;
+		}
+
+		if (frame < numFrames)
+		{
+			m_Segments.push_back({ frame, numFrames, m_Value, T{ 0 } });
+		}
+
+		// Whatever is left moves on to the next block
+		m_Breakpoints.erase(m_Breakpoints.begin(), m_Breakpoints.begin() + numUsed);
+
+		for (auto& breakpoint : m_Breakpoints)
+		{
+			breakpoint.frame -= numFrames;
+		}
+
+		m_IsChanged = m_Segments.size() > 1 || (!m_Segments.empty() && m_Segments[0].step != T{ 0 }) || start != m_Value;
+		m_Start = start;
+		m_Constant = m_Value;
+		m_NumFrames = numFrames;
+
+		// Blocks that hold one value never render
+		bool isConstant = m_Segments.size() <= 1 && (m_Segments.empty() || m_Segments[0].step == T{ 0 });
+		m_RenderState.store(isConstant ? k_Constant : k_Dirty, std::memory_order_release);
+	}
+
+	// Moves past the block without segments, so breakpoints never pile up unread
+	void Skip(count_t numFrames) override final
+	{
+		count_t frame = 0;
+		count_t numUsed = 0;
+
+		for (; numUsed < static_cast<count_t>(m_Breakpoints.size()); ++numUsed)
+		{
+			const Breakpoint& breakpoint = m_Breakpoints[numUsed];
+			count_t end = std::max(breakpoint.frame, frame);
+
+			if (end >= numFrames)
+			{
+				if (breakpoint.ramp == Ramp::Linear && end > frame)
+				{
+					m_Value += (breakpoint.value - m_Value) * static_cast<T>(numFrames - frame) / static_cast<T>(end - frame);
+				}
+
+				break;
+			}
+
+			frame = end;
+			m_Value = breakpoint.value;
+		}
+
+		m_Breakpoints.erase(m_Breakpoints.begin(), m_Breakpoints.begin() + numUsed);
+
+		for (auto& breakpoint : m_Breakpoints)
+		{
+			breakpoint.frame -= numFrames;
+		}
+	}
+
+	Ref_t<IStreamReader<T>> Stream() const override final
+	{
+		return MakeRef<Reader>(this);
+	}
+
+	Ref_t<IBlockReader<T>> Block() const override final
+	{
+		return this->Alias(m_BlockReader);
+	}
+
+private:
+	// Renders the segments on the first read of a block, readers can race for it
+	BlockSpan<T> Render() const
+	{
+		s32_t state = m_RenderState.load(std::memory_order_acquire);
+
+		if (state == k_Constant)
+		{
+			return { &m_Constant, 0, m_NumFrames, m_IsChanged };
+		}
+
+		if (state == k_Dirty &&
+			m_RenderState.compare_exchange_strong(state, k_Rendering, std::memory_order_acquire))
+		{
+			T* values = m_Block.values.data();
+
+			for (const Segment& segment : m_Segments)
+			{
+				for (count_t f = segment.begin; f < segment.end; ++f)
+				{
+					values[f] = segment.value + segment.step * static_cast<T>(f - segment.begin);
+				}
+			}
+
+			// Frame 0 changed against where the last block ended, rendered or not
+			m_Block.lastValue = m_Start;
+			m_Block.Analyze(m_NumFrames);
+			m_RenderState.store(k_Rendered, std::memory_order_release);
+		}
+
+		// Another reader is rendering, it's only a handful of segments
+		// Backs off to the scheduler in case the renderer was preempted mid-block.
+		for (count_t numSpins = 0; m_RenderState.load(std::memory_order_acquire) != k_Rendered; ++numSpins)
+		{
+			if (numSpins < k_MaxRenderSpins)
+			{
+				CpuRelax();
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		return m_Block.Span();
+	}
+
+private:
+	static constexpr s32_t k_Dirty = 0;
+	static constexpr s32_t k_Rendering = 1;
+	static constexpr s32_t k_Rendered = 2;
+	static constexpr s32_t k_Constant = 3;
+	static constexpr count_t k_MaxRenderSpins = 64;
+
+	std::vector<Breakpoint> m_Breakpoints;
+	std::vector<Segment> m_Segments;
+	// Value at the start of the next block
+	T m_Value;
+	T m_Start;
+	T m_Constant;
+	count_t m_NumFrames;
+	bool m_IsChanged;
+	mutable std::atomic<s32_t> m_RenderState;
+	mutable BlockValues<T> m_Block;
+	mutable Reader m_BlockReader{ this };
 };
 
 // Block parameter
@@ -431,9 +1244,10 @@ public:
 	class Reader : public IStreamReader<T>, public IBlockReader<T>
 	{
 	public:
-		Reader(const T* value, const bool* changed)
+		Reader(const T* value, const bool* changed, const count_t* numFrames)
 			: m_Value(value)
 			, m_Changed(changed)
+			, m_NumFrames(numFrames)
 		{
 		}
 
@@ -447,9 +1261,15 @@ public:
 			return { *m_Value, *m_Changed };
 		}
 
+		BlockSpan<T> Span() override final
+		{
+			return { m_Value, 0, *m_NumFrames, *m_Changed };
+		}
+
 	private:
 		const T* m_Value = nullptr;
 		const bool* m_Changed = nullptr;
+		const count_t* m_NumFrames = nullptr;
 	};
 };
 
@@ -461,118 +1281,205 @@ public:
 		: m_Binder(std::move(binder))
 		, m_Value(0.0f)
 		, m_Changed(false)
+		, m_NumFrames(0)
 	{
 	}
 
-	void Prepare(count_t numFrames, f32_t sampleRate) override final
+	void Prepare(count_t maxFrames, f32_t sampleRate) override final
 	{
 	}
 	
-	void Update() override final
+	void Update(count_t numFrames) override final
 	{
 		T value = m_Binder();
 		m_Changed = m_Value != value;
 		m_Value = value;
+		m_NumFrames = numFrames;
 	}
 
 	Ref_t<IStreamReader<T>> Stream() const override final
 	{
-		return MakeRef<typename BlockParameter<T>::Reader>(&m_Value, &m_Changed);
+		return MakeRef<typename BlockParameter<T>::Reader>(&m_Value, &m_Changed, &m_NumFrames);
 	}
 
-	Ref_t<IBlockReader<T >> Block() const override final
+	Ref_t<IBlockReader<T>> Block() const override final
 	{
-		return MakeRef<typename BlockParameter<T>::Reader>(&m_Value, &m_Changed);
+		return this->Alias(m_BlockReader);
 	}
 
 private:
 	F m_Binder;
 	T m_Value;
 	bool m_Changed;
+	count_t m_NumFrames;
+	mutable typename BlockParameter<T>::Reader m_BlockReader{ &m_Value, &m_Changed, &m_NumFrames };
 };
 
+// Parameter slot
+// Binds a stream's input to whichever parameter is used. Readers are created up front
+// and follow an atomically published pointer, flagging a change when it moves, so Use()
+// can rebind during playback without allocating. A parameter read through a slot has to
+// outlive reads in flight, which the registry owning it guarantees.
 template<typename T>
 class ParameterSlot
 {
 public:
 	class Reader : public IStreamReader<T>
 	{
-		friend class ParameterSlot<T>;
-		
 	public:
-		Reader(ParameterSlot<T>* slot)
-			: m_Default(slot->m_Default)
-			, m_Reslotted(false)
-			, m_Stream(nullptr)
+		Reader(const ParameterSlot<T>* slot)
+			: m_Slot(slot)
+			, m_Seen(nullptr)
+			, m_Span()
+			, m_FrameOffset(0)
 		{
 		}
 
+		// The span is fetched once per block, every frame after that only indexes it
 		IStreamReader<T>::Point Next() override final
 		{
-			T value = m_Default;
-			bool changed = false;
+			IBlockReader<T>* block = m_Slot->m_Bound.load(std::memory_order_acquire);
+			bool changed = block != m_Seen;
 
-			if (m_Stream)
+			if (changed || m_FrameOffset == 0)
 			{
-				auto next = m_Stream->Next();
-				value = next.Value();
-				changed = next.Changed();
+				m_Span = block ? block->Span() : BlockSpan<T>{ &m_Slot->m_Default, 0, 0, false };
+				m_Seen = block;
 			}
 
-			if (m_Reslotted)
+			count_t f = m_FrameOffset;
+			changed = changed || (m_Span.changes ? IsChangeSet(m_Span.changes, f) : f == 0 && m_Span.changed);
+
+			if (++m_FrameOffset >= m_Span.numFrames)
+			{
+				m_FrameOffset = 0;
+			}
+
+			return { m_Span[f], changed };
+		}
+
+	private:
+		const ParameterSlot<T>* m_Slot;
+		const IBlockReader<T>* m_Seen;
+		BlockSpan<T> m_Span;
+		count_t m_FrameOffset;
+	};
+
+	class BlockReader : public IBlockReader<T>
+	{
+	public:
+		BlockReader(const ParameterSlot<T>* slot)
+			: m_Slot(slot)
+			, m_Seen(nullptr)
+		{
+		}
+
+		IBlockReader<T>::Point Get(count_t f) const override final
+		{
+			IBlockReader<T>* block = m_Slot->m_Bound.load(std::memory_order_acquire);
+			T value = m_Slot->m_Default;
+			bool changed = block != m_Seen;
+
+			if (block)
 			{
-				changed = true;
-				m_Reslotted = false;
+				auto point = block->Get(f);
+				value = point.Value();
+				changed = changed || point.Changed();
 			}
 
 			return { value, changed };
 		}
 
+		// Nothing slotted yet is a constant block of the default, it has no length of its own
+		BlockSpan<T> Span() override final
+		{
+			IBlockReader<T>* block = m_Slot->m_Bound.load(std::memory_order_acquire);
+			BlockSpan<T> span = { &m_Slot->m_Default, 0, 0, false };
+
+			if (block)
+			{
+				span = block->Span();
+			}
+
+			if (block != m_Seen)
+			{
+				span.changed = true;
+				m_Seen = block;
+			}
+
+			return span;
+		}
+
 	private:
-		T m_Default;
-		bool m_Reslotted;
-		Ref_t<IStreamReader<T>> m_Stream;
+		const ParameterSlot<T>* m_Slot;
+		const IBlockReader<T>* m_Seen;
 	};
 
 public:
 	ParameterSlot(T value, T min = f32::k_Min, T max = f32::k_Max)
 		: m_Default(value)
 		, m_Used(nullptr)
+		, m_UsedBlock(nullptr)
+		, m_Bound(nullptr)
 	{
 	}
 
-	void Use(Ref_t<Parameter<T>> parameter)
+	~ParameterSlot()
 	{
-		if (m_Used != parameter)
+		if (m_Used)
 		{
-			m_Used = parameter;
-			for (auto& reader : m_Readers)
-			{
-				reader->m_Reslotted = true;
-				reader->m_Stream = m_Used->Stream();
-			}
+			m_Used->mNumSlots.fetch_sub(1, std::memory_order_relaxed);
 		}
 	}
 
-	Ref_t<IStreamReader<T>> Get()
+	// Slots count towards what the registry evaluates and readers point at them, so they're never copied
+	ParameterSlot(const ParameterSlot&) = delete;
+	ParameterSlot& operator=(const ParameterSlot&) = delete;
+
+	// Realtime safe, only ever call from one thread at a time
+	// Null unbinds, readers then go back to the default.
+	void Use(Ref_t<Parameter<T>> parameter)
 	{
-		auto reader = MakeRef<Reader>(this);
+		if (m_Used == parameter)
+		{
+			return;
+		}
 
 		if (m_Used)
 		{
-			reader->m_Reslotted = true;
-			reader->m_Stream = m_Used->Stream();
+			m_Used->mNumSlots.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		m_UsedBlock = nullptr;
+
+		if (parameter)
+		{
+			parameter->mNumSlots.fetch_add(1, std::memory_order_relaxed);
+
+			// Library parameters hand out embedded readers, so nothing here allocates
+			m_UsedBlock = parameter->Block();
 		}
 
-		m_Readers.push_back(reader);
+		m_Used = std::move(parameter);
+		m_Bound.store(m_UsedBlock.get(), std::memory_order_release);
+	}
+
+	// Creates a reader, call while preparing rather than processing
+	Ref_t<IStreamReader<T>> Get() const
+	{
+		return MakeRef<Reader>(this);
+	}
 
-		return reader;
+	// Reads whole blocks through Span() rather than sample by sample
+	Ref_t<IBlockReader<T>> GetBlock() const
+	{
+		return MakeRef<BlockReader>(this);
 	}
 
 private:
 	T m_Default;
 	Ref_t<Parameter<T>> m_Used;
-	std::vector<Ref_t<Reader>> m_Readers;
+	Ref_t<IBlockReader<T>> m_UsedBlock;
+	std::atomic<IBlockReader<T>*> m_Bound;
 };
-
 }
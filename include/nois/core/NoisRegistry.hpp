@@ -1,10 +1,20 @@
 #pragma once
 
 #include "nois/NoisTypes.hpp"
+#include "nois/core/NoisExecutor.hpp"
+#include "nois/core/NoisExpression.hpp"
 #include "nois/core/NoisParameter.hpp"
 #include "nois/core/NoisStream.hpp"
+#include "nois/util/NoisSpscQueue.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <functional>
+#include <typeindex>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace nois {
@@ -20,38 +30,246 @@ class Registry
 	// TODO: create processors here
 	// They'll be auto-registered and dependencies can be resolved.
 
+public:
+	using Result = typename Stream<T>::Result;
+
+	// Time spent rendering blocks, in nanoseconds
+	// Load is the time over the realtime length of the block, above 1 the deadline was missed.
+	struct Timing
+	{
+		u64_t lastNanos = 0;
+		u64_t averageNanos = 0;
+		u64_t maxNanos = 0;
+		f32_t lastLoad = 0.0f;
+		f32_t maxLoad = 0.0f;
+		u64_t numBlocks = 0;
+	};
+
+	// One graph and the span to push through it, see RenderBatch()
+	struct RenderJob
+	{
+		Registry<T>* registry = nullptr;
+		ConstBufferView<T> inBuffer = { nullptr, 0, 0 };
+		BufferView<T> outBuffer = { nullptr, 0, 0 };
+		f32_t sampleRate = 0.0f;
+	};
+
+	static constexpr count_t k_RenderBlockSize = 4096;
+
 private:
+	using Clock = std::chrono::steady_clock;
+
+	// Counters one thread writes after every block and any thread reads
+	// The average is exponential so it follows the recent load rather than all time.
+	class TimingCounters
+	{
+	public:
+		void Record(Clock::time_point start, f32_t budgetNanos)
+		{
+			u64_t nanos = static_cast<u64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+			u64_t numBlocks = m_NumBlocks.load(std::memory_order_relaxed);
+			s64_t average = static_cast<s64_t>(m_AverageNanos.load(std::memory_order_relaxed));
+			f32_t load = budgetNanos > 0.0f ? static_cast<f32_t>(nanos) / budgetNanos : 0.0f;
+
+			average = numBlocks == 0 ? static_cast<s64_t>(nanos) : average + (static_cast<s64_t>(nanos) - average) / k_AverageBlocks;
+
+			m_LastNanos.store(nanos, std::memory_order_relaxed);
+			m_AverageNanos.store(static_cast<u64_t>(average), std::memory_order_relaxed);
+			m_MaxNanos.store(std::max(nanos, m_MaxNanos.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+			m_LastLoad.store(load, std::memory_order_relaxed);
+			m_MaxLoad.store(std::max(load, m_MaxLoad.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+			m_NumBlocks.store(numBlocks + 1, std::memory_order_relaxed);
+		}
+
+		Timing Load() const
+		{
+			Timing timing;
+			timing.lastNanos = m_LastNanos.load(std::memory_order_relaxed);
+			timing.averageNanos = m_AverageNanos.load(std::memory_order_relaxed);
+			timing.maxNanos = m_MaxNanos.load(std::memory_order_relaxed);
+			timing.lastLoad = m_LastLoad.load(std::memory_order_relaxed);
+			timing.maxLoad = m_MaxLoad.load(std::memory_order_relaxed);
+			timing.numBlocks = m_NumBlocks.load(std::memory_order_relaxed);
+			return timing;
+		}
+
+	private:
+		static constexpr s64_t k_AverageBlocks = 32;
+
+		std::atomic<u64_t> m_LastNanos = 0;
+		std::atomic<u64_t> m_AverageNanos = 0;
+		std::atomic<u64_t> m_MaxNanos = 0;
+		std::atomic<f32_t> m_LastLoad = 0.0f;
+		std::atomic<f32_t> m_MaxLoad = 0.0f;
+		std::atomic<u64_t> m_NumBlocks = 0;
+	};
+
 	enum class NodeState : uint8_t
 	{
 		Unvisited,
+		Visiting,
 		Visited
 	};
 
+	// What a node was last prepared with
+	// Shared by every plan the node is part of, so swapping plans only prepares new nodes.
+	struct NodeRuntime
+	{
+		count_t numFrames = 0;
+		count_t numChannels = 0;
+		f32_t sampleRate = 0.0f;
+		// Frames processed since the input went silent, saturates at the tail
+		count_t silentFrames = 0;
+		// Latency the stream last reported, published by whichever thread owns the node
+		// so compiling never asks a stream the audio thread is running.
+		std::atomic<count_t> latencyFrames = 0;
+		TimingCounters timing;
+	};
+
 	struct ParameterNode
 	{
 		Ref_t<Parameter<T>> object = nullptr;
+		Ref_t<NodeRuntime> runtime = nullptr;
 		std::vector<size_t> dependencies;
 		NodeState state = NodeState::Unvisited;
+		count_t step = 0;
+		// Set once a plan holds the node, from then on only the audio thread prepares it
+		bool isCompiled = false;
 	};
 	
 	struct StreamNode
 	{
 		Ref_t<Stream<T>> object = nullptr;
+		Ref_t<NodeRuntime> runtime = nullptr;
 		std::vector<size_t> dependencies;
 		NodeState state = NodeState::Unvisited;
-		Buffer<T> buffer;
+		count_t step = 0;
+		bool isCompiled = false;
+	};
+
+	// Transformer parameter other creations of an equal transform resolve to
+	// Only transformers comparable with == are shared, lambdas never compare equal.
+	struct SharedTransform
+	{
+		bool isBlock = false;
+		std::type_index type = typeid(void);
+		std::vector<const Parameter<T>*> inputs;
+		std::function<bool(const void*)> matches;
+		Ref_t<Parameter<T>> parameter = nullptr;
+	};
+
+	// Flattened step of the compiled schedule
+	// Pointers are resolved once at compile time so running never looks nodes up.
+	struct ParameterStep
+	{
+		Parameter<T>* object = nullptr;
+		NodeRuntime* runtime = nullptr;
+		count_t dependencyOffset = 0;
+		count_t numDependencies = 0;
+	};
+
+	struct StreamStep
+	{
+		Stream<T>* object = nullptr;
+		NodeRuntime* runtime = nullptr;
+		Buffer<T>* buffer = nullptr;
+		const Buffer<T>* upstream = nullptr;
+		count_t upstreamOffset = 0;
+		count_t numUpstreams = 0;
+		// Set when the stream has several dependencies, they're summed here first
+		Buffer<T>* mixBuffer = nullptr;
+		count_t mixUpstreamOffset = 0;
+		count_t numMixUpstreams = 0;
+	};
+
+	// Delay line lining one mixed input up with the slowest one
+	// Every line lives in the plan's compensation arena, one channel after the other.
+	struct Compensation
+	{
+		count_t numFrames = 0;
+		count_t offset = 0;
+		count_t position = 0;
+		// Edge the line delays, so the next plan can pick up where this one left off
+		const NodeRuntime* upstream = nullptr;
+		const NodeRuntime* downstream = nullptr;
+	};
+
+	// Compiled graph handed from the control thread to the audio thread
+	// Nothing in it changes once published, apart from the buffers the audio thread renders into.
+	struct Plan
+	{
+		std::vector<ParameterStep> parameterSchedule;
+		std::vector<count_t> parameterDependencies;
+		// Which parameter steps something reads this block
+		std::vector<uint8_t> neededParameters;
+		std::vector<StreamStep> streamSchedule;
+		std::vector<const Buffer<T>*> mixUpstreams;
+		std::vector<count_t> upstreamSteps;
+		std::vector<Buffer<T>> bufferPool;
+		const Buffer<T>* sinkBuffer = nullptr;
+		count_t sinkStep = -1;
+		count_t numFrames = 0;
+		count_t numChannels = 0;
+
+		Ref_t<Executor> executor = nullptr;
+		std::vector<count_t> taskNumDependencies;
+		std::vector<count_t> taskDependentOffsets;
+		std::vector<count_t> taskDependents;
+		ConstBufferView<T> processInBuffer = { nullptr, 0, 0 };
+
+		// What every step returned this block, written as steps run
+		std::vector<Result> results;
+		bool isInputSilent = false;
+
+		// Realtime length of the current block
+		f32_t budgetNanos = 0.0f;
+
+		// Latency at every step output and the delays that compensate it where inputs mix
+		// Compensations run parallel to mixUpstreams and share one arena.
+		std::vector<count_t> latencies;
+		std::vector<Compensation> compensations;
+		std::vector<count_t> compensationTails;
+		Buffer<T> compensationArena;
+		count_t compensationCapacity = 0;
+		count_t compensationChannels = 0;
+
+		// Keeps the nodes alive for as long as the plan can still run
+		std::vector<Ref_t<void>> objects;
 	};
 
+	static constexpr count_t k_NumRetiredPlans = 8;
+
+	// Executor tasks reserved at the least, graphs past the reservation run serially
+	static constexpr count_t k_MinExecutorTasks = 256;
+
 public:
 	Registry()
-		: m_NumFrames(0)
+		: m_SourceIndex(0)
+		, m_SinkIndex(0)
+		, m_IsScheduleDirty(true)
+		, m_Executor(nullptr)
+		, m_NumExecutorTasks(0)
+		, m_PendingPlan(nullptr)
+		, m_RetiredPlans(k_NumRetiredPlans)
+		, m_IsLatencyOutgrown(false)
+		, m_ActivePlan(nullptr)
+		, m_MaxNumFrames(0)
+		, m_IsMaxPrepared(false)
 		, m_NumChannels(0)
 		, m_SampleRate(0.0f)
-		, m_SourceIndex(0)
-		, m_SinkIndex(0)
+		, m_LatencyFrames(0)
+	{
+	}
+
+	~Registry()
 	{
+		delete m_PendingPlan.load(std::memory_order_acquire);
+		CollectRetiredPlans();
 	}
 
+	Registry(const Registry&) = delete;
+	Registry& operator=(const Registry&) = delete;
+
 	template<typename F>
 	Ref_t<SampleParameter<T>> CreateSampleBinder(F&& binder)
 	{
@@ -60,8 +278,42 @@ public:
 		
 		ParameterNode node;
 		node.object = parameter;
+		node.runtime = MakeRef<NodeRuntime>();
+		m_ParameterNodes.emplace_back(node);
+		m_ParameterLookup.emplace(parameter, m_ParameterNodes.size() - 1);
+		m_IsScheduleDirty = true;
+
+		return parameter;
+	}
+
+	// Fed from another thread with Push(), see QueueParameter
+	Ref_t<QueueParameter<T>> CreateQueue(T value, count_t capacity = QueueParameter<T>::k_DefaultCapacity)
+	{
+		auto parameter = MakeRef<QueueParameter<T>>(value, capacity);
+		parameter->mRegistry = this;
+		
+		ParameterNode node;
+		node.object = parameter;
+		node.runtime = MakeRef<NodeRuntime>();
 		m_ParameterNodes.emplace_back(node);
 		m_ParameterLookup.emplace(parameter, m_ParameterNodes.size() - 1);
+		m_IsScheduleDirty = true;
+
+		return parameter;
+	}
+
+	// Fed with breakpoints per block, see AutomationParameter
+	Ref_t<AutomationParameter<T>> CreateAutomation(T value, count_t capacity = AutomationParameter<T>::k_DefaultCapacity)
+	{
+		auto parameter = MakeRef<AutomationParameter<T>>(value, capacity);
+		parameter->mRegistry = this;
+		
+		ParameterNode node;
+		node.object = parameter;
+		node.runtime = MakeRef<NodeRuntime>();
+		m_ParameterNodes.emplace_back(node);
+		m_ParameterLookup.emplace(parameter, m_ParameterNodes.size() - 1);
+		m_IsScheduleDirty = true;
 
 		return parameter;
 	}
@@ -74,15 +326,27 @@ public:
 		
 		ParameterNode node;
 		node.object = parameter;
+		node.runtime = MakeRef<NodeRuntime>();
 		m_ParameterNodes.emplace_back(node);
 		m_ParameterLookup.emplace(parameter, m_ParameterNodes.size() - 1);
+		m_IsScheduleDirty = true;
 
 		return parameter;
 	}
 
+	// Transformers that compare equal over the same inputs share one parameter, which
+	// then also shares its settings like the control interval. A parameter whose interval
+	// was changed isn't handed out anymore, the next equal transform gets one of its own.
 	template<typename F, typename... Params>
 	Ref_t<Parameter<T>> CreateTransformer(F&& transformer, Params&&... transformees)
 	{
+		std::vector<const Parameter<T>*> inputs = { transformees.get()... };
+
+		if (auto shared = FindSharedTransform(false, transformer, inputs))
+		{
+			return shared;
+		}
+
 		ParameterNode node;
 
 		// Add the dependencies
@@ -95,11 +359,60 @@ public:
 		parameter->mRegistry = this;
 
 		node.object = parameter;
+		node.runtime = MakeRef<NodeRuntime>();
+		m_ParameterNodes.emplace_back(node);
+		m_ParameterLookup.emplace(parameter, m_ParameterNodes.size() - 1);
+		m_IsScheduleDirty = true;
+
+		ShareTransform(false, parameter, std::move(inputs));
+
+		return parameter;
+	}
+	
+	// Like CreateTransformer(), but the transformer fills whole blocks from spans
+	template<typename F, typename... Params>
+	Ref_t<Parameter<T>> CreateBlockTransformer(F&& transformer, Params&&... transformees)
+	{
+		std::vector<const Parameter<T>*> inputs = { transformees.get()... };
+
+		if (auto shared = FindSharedTransform(true, transformer, inputs))
+		{
+			return shared;
+		}
+
+		ParameterNode node;
+
+		// Add the dependencies
+		(node.dependencies.emplace_back(m_ParameterLookup[transformees]), ...);
+
+		auto parameter =
+			MakeRef<BlockTransformerParameter<T, std::decay_t<F>, Params...>>(
+				std::forward<F>(transformer),
+				std::forward<Params>(transformees)...);
+		parameter->mRegistry = this;
+
+		node.object = parameter;
+		node.runtime = MakeRef<NodeRuntime>();
 		m_ParameterNodes.emplace_back(node);
 		m_ParameterLookup.emplace(parameter, m_ParameterNodes.size() - 1);
+		m_IsScheduleDirty = true;
+
+		ShareTransform(true, parameter, std::move(inputs));
 
 		return parameter;
 	}
+
+	// Runs a compiled expression over the inputs, nullptr when they don't match its x, y, z, w
+	template<typename... Params>
+	Ref_t<Parameter<T>> CreateExpression(const Ref_t<Expression>& expression, Params&&... inputs)
+	{
+		if (!expression || expression->GetNumInputs() != static_cast<count_t>(sizeof...(Params)))
+		{
+			return nullptr;
+		}
+
+		return CreateBlockTransformer(ExpressionTransformer{ expression }, std::forward<Params>(inputs)...);
+	}
 	
 	template<typename S, typename... Args>
 	Ref_t<S> CreateStream(Args&&... args)
@@ -111,199 +424,1305 @@ public:
 
 		StreamNode node;
 		node.object = stream;
+		node.runtime = MakeRef<NodeRuntime>();
 		
 		m_StreamNodes.emplace_back(node);
 		m_StreamLookup.emplace(stream, m_StreamNodes.size() - 1);
+		m_IsScheduleDirty = true;
 
 		return stream;
 	}
 
-	void Run(ConstBufferView<T> inBuffer, BufferView<T> outBuffer, f32_t sampleRate)
+	void Connect(Ref_t<Stream<T>> upstream, Ref_t<Stream<T>> downstream)
 	{
-		NOIS_PROFILE_SCOPE_NAMED("Run Graph");
-		
-		count_t numFrames = inBuffer.GetNumFrames();
-		count_t numChannels = inBuffer.GetNumChannels();
-		
+		auto upstreamIt = m_StreamLookup.find(upstream);
+		auto downstreamIt = m_StreamLookup.find(downstream);
+
+		if (upstreamIt == m_StreamLookup.end() ||
+			downstreamIt == m_StreamLookup.end())
 		{
-			NOIS_PROFILE_SCOPE_NAMED("Update Parameters");
-			
-			// TODO: prepare when MetaParameter changes
-			bool doPrepare =
-				numFrames != m_NumFrames ||
-				sampleRate != m_SampleRate;
-			
-			for (auto& node : m_ParameterNodes)
-			{
-				node.state = NodeState::Unvisited;
-			}
-			
-			for (auto& node : m_ParameterNodes)
-			{
-				ParameterUpdateVisit(
-					&node,
-					numFrames,
-					sampleRate,
-					doPrepare);
-			}
+			return;
 		}
-		
+
+		auto& dependencies = m_StreamNodes[downstreamIt->second].dependencies;
+
+		if (std::find(dependencies.begin(), dependencies.end(), upstreamIt->second) == dependencies.end())
 		{
-			NOIS_PROFILE_SCOPE_NAMED("Update Streams");
-			
-			bool doPrepare =
-				numFrames != m_NumFrames ||
-				numChannels != m_NumChannels ||
-				sampleRate != m_SampleRate;
-			
-			for (auto& node : m_StreamNodes)
-			{
-				node.state = NodeState::Unvisited;
-			}
-			
-			for (auto& node : m_StreamNodes)
-			{
-				StreamUpdateVisit(
-					&node,
-					numFrames,
-					numChannels,
-					sampleRate,
-					doPrepare);
-			}
+			dependencies.emplace_back(upstreamIt->second);
+			m_IsScheduleDirty = true;
 		}
-		
+	}
+
+	// Publishes the staged graph to the audio thread
+	// Compiles on the calling thread, Run() picks the plan up at the start of its next block.
+	// Creating nodes, connecting them and setting the sink only touch the staged graph,
+	// so all of it can happen on a control thread while audio keeps running.
+	void Commit()
+	{
+		NOIS_PROFILE_SCOPE();
+
+		CollectRetiredPlans();
+
+		// The audio thread asks for a recompile when latencies outgrow the delay arena
+		if (m_IsLatencyOutgrown.exchange(false, std::memory_order_relaxed))
 		{
-			NOIS_PROFILE_SCOPE_NAMED("Process");
-			
-			ScopedNoDenorms noDenorms;
-			
-			for (auto& node : m_StreamNodes)
-			{
-				node.state = NodeState::Unvisited;
-			}
-			
-			for (auto& node : m_StreamNodes)
-			{
-				StreamProcessVisit(
-					&node,
-					inBuffer);
-			}
-			
-			if (m_SinkIndex < m_StreamNodes.size())
-			{
-				outBuffer.Copy(m_StreamNodes[m_SinkIndex].buffer);
-			}
+			m_IsScheduleDirty = true;
 		}
-		
-		m_NumFrames = numFrames;
-		m_NumChannels = numChannels;
-		m_SampleRate = sampleRate;
+
+		if (!m_IsScheduleDirty)
+		{
+			return;
+		}
+
+		Own_t<Plan> plan = Compile();
+
+		// Hosts ask for the latency before the first block, so it's known once compiled
+		m_LatencyFrames.store(GetSinkLatency(*plan), std::memory_order_relaxed);
+
+		// A plan that was never picked up was never seen by the audio thread either
+		delete m_PendingPlan.exchange(plan.release(), std::memory_order_acq_rel);
 	}
-	
-	void SetSource(Ref_t<Stream<T>> stream)
+
+	// Frees plans the audio thread has swapped out, Commit() does this too
+	void CollectRetiredPlans()
 	{
-		m_SourceIndex = m_StreamLookup[stream];
+		Own_t<Plan> plan;
+
+		while (m_RetiredPlans.Pop(plan))
+		{
+			plan = nullptr;
+		}
 	}
-	
-	void SetSink(Ref_t<Stream<T>> stream)
+
+	// Prepares every node for blocks of up to maxFrames and commits the staged graph
+	// Everything is allocated here, afterwards Run() takes any block size up to maxFrames
+	// without preparing again. Call it while Run() isn't running, like a host's setup phase.
+	void PrepareMax(count_t maxFrames, count_t numChannels, f32_t sampleRate)
 	{
-		m_SinkIndex = m_StreamLookup[stream];
+		NOIS_PROFILE_SCOPE();
+
+		m_MaxNumFrames.store(maxFrames, std::memory_order_relaxed);
+		m_IsMaxPrepared.store(true, std::memory_order_relaxed);
+		m_NumChannels.store(numChannels, std::memory_order_relaxed);
+		m_SampleRate.store(sampleRate, std::memory_order_relaxed);
+
+		m_HostBuffer.Resize(maxFrames, numChannels);
+
+		for (auto& node : m_ParameterNodes)
+		{
+			node.object->Prepare(maxFrames, sampleRate);
+			node.runtime->numFrames = maxFrames;
+			node.runtime->sampleRate = sampleRate;
+		}
+
+		for (auto& node : m_StreamNodes)
+		{
+			node.object->Prepare(maxFrames, numChannels, sampleRate);
+			node.runtime->numFrames = maxFrames;
+			node.runtime->numChannels = numChannels;
+			node.runtime->sampleRate = sampleRate;
+			node.runtime->latencyFrames.store(node.object->GetLatencyFrames(), std::memory_order_relaxed);
+		}
+
+		ReserveExecutor();
+
+		// Recompile so buffers and delays are sized for what the nodes were just prepared with
+		m_IsScheduleDirty = true;
+		Commit();
 	}
-	
-private:
-	void ParameterUpdateVisit(ParameterNode* node, count_t numFrames, f32_t sampleRate, bool doPrepare)
+
+	// Returns what the sink returned, Starved when there's no plan or sink to run
+	// Plans are only built by Commit() or PrepareMax(), until one is published this outputs silence.
+	// Blocks longer than PrepareMax() allowed for run in pieces of the maximum. Without a
+	// prepared maximum the nodes are prepared again whenever a block is the longest yet.
+	Result Run(ConstBufferView<T> inBuffer, BufferView<T> outBuffer, f32_t sampleRate)
 	{
-		if (node->state == NodeState::Visited)
+		if (IsPastMaxFrames(inBuffer.GetNumFrames()))
 		{
-			return;
+			return Run(
+				StridedBufferView<const T>::Planar(inBuffer.Data(), inBuffer.GetNumFrames(), inBuffer.GetNumChannels()),
+				StridedBufferView<T>::Planar(outBuffer.Data(), outBuffer.GetNumFrames(), outBuffer.GetNumChannels()),
+				sampleRate);
 		}
 
-		for (auto index : node->dependencies)
+		return RunGraph(
+			inBuffer,
+			sampleRate,
+			[&](const Buffer<T>* sinkBuffer)
+			{
+				// Copied per channel, so a sink with fewer channels leaves the rest silent
+				if (sinkBuffer)
+				{
+					StridedBufferView<T>::Planar(outBuffer.Data(), outBuffer.GetNumFrames(), outBuffer.GetNumChannels()).CopyFrom(*sinkBuffer);
+				}
+				else
+				{
+					outBuffer.Zero();
+				}
+			});
+	}
+
+	// Runs on samples in any layout, like a host's own buffers
+	// Planar input is read in place, other input layouts are converted once into a buffer
+	// kept for it. The sink is copied into outBuffer in whatever layout that has.
+	// Input without channels is Starved and leaves outBuffer silent.
+	Result Run(StridedBufferView<const T> inBuffer, StridedBufferView<T> outBuffer, f32_t sampleRate)
+	{
+		count_t numFrames = inBuffer.GetNumFrames();
+
+		if (!IsPastMaxFrames(numFrames))
 		{
-			ParameterUpdateVisit(&m_ParameterNodes[index], numFrames, sampleRate, doPrepare);
+			return RunStrided(inBuffer, outBuffer, sampleRate);
 		}
 
-		if (doPrepare)
+		count_t maxFrames = m_MaxNumFrames.load(std::memory_order_relaxed);
+		Result result = Stream<T>::Silent;
+
+		for (count_t offset = 0; offset < numFrames; offset += maxFrames)
 		{
-			node->object->Prepare(numFrames, sampleRate);
+			Result blockResult = RunStrided(inBuffer.Slice(offset, maxFrames), outBuffer.Slice(offset, maxFrames), sampleRate);
+
+			// Silent only when every piece was, otherwise the worst of the rest
+			if (blockResult != Stream<T>::Silent)
+			{
+				result = result == Stream<T>::Silent ? blockResult : std::max(result, blockResult);
+			}
 		}
 
-		node->object->Update();
-		
-		node->state = NodeState::Visited;
+		return result;
 	}
 	
-	void StreamUpdateVisit(StreamNode* node, count_t numFrames, count_t numChannels, f32_t sampleRate, bool doPrepare)
+	// Pushes a whole span through the graph as fast as the machine allows
+	// The span is cut into blocks of blockSize that run back to back, with independent
+	// branches spread over the executor when one is set. Like Run() it renders the last
+	// committed plan and must never be called while Run() is running.
+	void Render(ConstBufferView<T> inBuffer, BufferView<T> outBuffer, f32_t sampleRate, count_t blockSize = k_RenderBlockSize)
 	{
-		if (node->state == NodeState::Visited)
+		NOIS_PROFILE_SCOPE();
+
+		count_t numFrames = std::min(inBuffer.GetNumFrames(), outBuffer.GetNumFrames());
+
+		if (numFrames <= 0 || blockSize <= 0)
 		{
 			return;
 		}
 
-		for (auto index : node->dependencies)
-		{
-			StreamUpdateVisit(&m_StreamNodes[index], numFrames, numChannels, sampleRate, doPrepare);
-		}
+		// Blocks are views into the span, mono input is read in place
+		// A slice keeps the span's channel stride, so more channels are gathered block by block.
+		auto inSpan = StridedBufferView<const T>::Planar(inBuffer.Data(), inBuffer.GetNumFrames(), inBuffer.GetNumChannels());
+		auto outSpan = StridedBufferView<T>::Planar(outBuffer.Data(), outBuffer.GetNumFrames(), outBuffer.GetNumChannels());
 
-		if (doPrepare)
+		for (count_t offset = 0; offset < numFrames; offset += blockSize)
 		{
-			node->buffer.Resize(numFrames, numChannels);
-			node->object->Prepare(numFrames, numChannels, sampleRate);
+			count_t numBlockFrames = std::min(blockSize, numFrames - offset);
+
+			Run(inSpan.Slice(offset, numBlockFrames), outSpan.Slice(offset, numBlockFrames), sampleRate);
 		}
-		
-		node->object->Update();
 
-		node->state = NodeState::Visited;
+		CollectRetiredPlans();
 	}
-	
-	Stream<T>::Result StreamProcessVisit(StreamNode* node, ConstBufferView<T> inBuffer)
+
+	// Renders independent graphs side by side, one executor task per job
+	// Every job needs a registry of its own. The executor doesn't nest, a job registry using
+	// this executor for its branches gets refused and runs them serially. Registries are
+	// committed on the calling thread before the jobs are spread out.
+	// When another thread holds the executor the jobs all render on the calling thread.
+	static void RenderBatch(Executor& executor, std::vector<RenderJob>& jobs, count_t blockSize = k_RenderBlockSize)
 	{
-		if (node->state == NodeState::Visited)
+		NOIS_PROFILE_SCOPE();
+
+		for (RenderJob& job : jobs)
 		{
-			return Stream<T>::Success;
+			job.registry->Commit();
 		}
 
-		typename Stream<T>::Result result = Stream<T>::Success;
-		
-		for (auto index : node->dependencies)
+		struct Batch
+		{
+			RenderJob* jobs;
+			count_t blockSize;
+		};
+
+		count_t numJobs = static_cast<count_t>(jobs.size());
+		Batch batch = { jobs.data(), blockSize };
+
+		// Nothing depends on anything, every job is a root
+		std::vector<count_t> numDependencies(numJobs, 0);
+		std::vector<count_t> dependentOffsets(numJobs + 1, 0);
+
+		Executor::Graph graph;
+		graph.numTasks = numJobs;
+		graph.numDependencies = numDependencies.data();
+		graph.dependentOffsets = dependentOffsets.data();
+		graph.run = [](void* context, count_t task)
 		{
-			result = StreamProcessVisit(&m_StreamNodes[index], inBuffer);
+			auto* batch = static_cast<Batch*>(context);
+			RenderJob& job = batch->jobs[task];
+
+			job.registry->Render(job.inBuffer, job.outBuffer, job.sampleRate, batch->blockSize);
+		};
+		graph.context = &batch;
 
-			if (result != Stream<T>::Success)
+		executor.Reserve(numJobs);
+
+		if (!executor.Execute(graph))
+		{
+			for (count_t i = 0; i < numJobs; ++i)
 			{
-				break;
+				graph.run(graph.context, i);
 			}
 		}
+	}
 
-		if (node->dependencies.empty())
+	void SetSource(Ref_t<Stream<T>> stream)
+	{
+		m_SourceIndex = m_StreamLookup[stream];
+	}
+	
+	void SetSink(Ref_t<Stream<T>> stream)
+	{
+		m_SinkIndex = m_StreamLookup[stream];
+		m_IsScheduleDirty = true;
+	}
+
+	// Spreads independent stream branches over the executor's workers
+	// Each node keeps writing its own buffer, so the sink output is the same as running serially.
+	// The executor is reserved here and by PrepareMax(), never by Commit(), so call both while
+	// Run() isn't running. Plans with more streams than reserved for run serially.
+	void SetExecutor(Ref_t<Executor> executor)
+	{
+		m_Executor = executor;
+		m_NumExecutorTasks = 0;
+		m_IsScheduleDirty = true;
+
+		ReserveExecutor();
+	}
+
+	// Timing of whole runs, safe to call from any thread
+	Timing GetTiming() const
+	{
+		return m_Timing.Load();
+	}
+
+	// Timing of one stream, including mixing its inputs
+	// Looks the stream up in the staged graph, so call it where nodes are created.
+	// The counters themselves are lock-free and keep counting across commits.
+	Timing GetTiming(const Ref_t<Stream<T>>& stream) const
+	{
+		auto it = m_StreamLookup.find(stream);
+
+		if (it == m_StreamLookup.end())
 		{
-			result = node->object->Process(inBuffer, node->buffer);
+			return Timing();
 		}
-		else
-		{
-			// TODO: mix multiple dependencies?
-			auto& upstreamNode = m_StreamNodes[node->dependencies.front()];
 
-			result = node->object->Process(upstreamNode.buffer, node->buffer);
-		}
-		
-		node->state = NodeState::Visited;
-		
-		return result;
+		return m_StreamNodes[it->second].runtime->timing.Load();
 	}
 
+	// Frames the sink lags behind the input as of the last commit or run, for reporting to hosts
+	count_t GetLatencyFrames() const
+	{
+		return m_LatencyFrames.load(std::memory_order_relaxed);
+	}
+	
 private:
-	count_t m_NumFrames;
-	count_t m_NumChannels;
-	f32_t m_SampleRate;
+	// Only a maximum from PrepareMax() is a hard limit, otherwise longer blocks raise it
+	bool IsPastMaxFrames(count_t numFrames) const
+	{
+		count_t maxFrames = m_MaxNumFrames.load(std::memory_order_relaxed);
+		return m_IsMaxPrepared.load(std::memory_order_relaxed) && numFrames > maxFrames;
+	}
 
-	std::vector<ParameterNode> m_ParameterNodes;
+	// Runs a block no longer than the maximum, converting other layouts on the way
+	Result RunStrided(StridedBufferView<const T> inBuffer, StridedBufferView<T> outBuffer, f32_t sampleRate)
+	{
+		// Hosts hand over buses without channels, there's not even a first one to view
+		if (inBuffer.GetNumChannels() <= 0)
+		{
+			outBuffer.Zero();
+			return Stream<T>::Starved;
+		}
+
+		ConstBufferView<T> planarInBuffer = { nullptr, 0, 0 };
+
+		if (inBuffer.IsPlanar())
+		{
+			planarInBuffer = inBuffer.AsPlanar();
+		}
+		else
+		{
+			// Sized by PrepareMax(), only a block without a prepared maximum allocates
+			m_HostBuffer.Reshape(inBuffer.GetNumFrames(), inBuffer.GetNumChannels());
+			inBuffer.CopyTo(m_HostBuffer);
+			planarInBuffer = std::as_const(m_HostBuffer);
+		}
+
+		return RunGraph(
+			planarInBuffer,
+			sampleRate,
+			[&](const Buffer<T>* sinkBuffer)
+			{
+				if (sinkBuffer)
+				{
+					outBuffer.CopyFrom(*sinkBuffer);
+				}
+				else
+				{
+					outBuffer.Zero();
+				}
+			});
+	}
+
+	// Runs a block, writeSink(sinkBuffer) hands the result over while it's still timed
+	// The sink buffer is null when there's nothing to play, the output is silent then.
+	template<typename F>
+	Result RunGraph(ConstBufferView<T> inBuffer, f32_t sampleRate, F&& writeSink)
+	{
+		NOIS_PROFILE_SCOPE_NAMED("Run Graph");
+
+		Clock::time_point start = Clock::now();
+		
+		count_t numFrames = inBuffer.GetNumFrames();
+		count_t numChannels = inBuffer.GetNumChannels();
+
+		// Run() splits anything longer than prepared, only an unprepared graph takes its size from the block
+		count_t maxFrames = m_MaxNumFrames.load(std::memory_order_relaxed);
+
+		if (numFrames > maxFrames)
+		{
+			maxFrames = numFrames;
+			m_MaxNumFrames.store(maxFrames, std::memory_order_relaxed);
+		}
+
+		m_NumChannels.store(numChannels, std::memory_order_relaxed);
+		m_SampleRate.store(sampleRate, std::memory_order_relaxed);
+
+		// Only swap when the old plan has somewhere to go, it's never freed here
+		if (m_PendingPlan.load(std::memory_order_relaxed) &&
+			m_RetiredPlans.CanPush())
+		{
+			Own_t<Plan> plan(m_PendingPlan.exchange(nullptr, std::memory_order_acq_rel));
+
+			std::swap(plan, m_ActivePlan);
+
+			if (plan)
+			{
+				CarryCompensations(*plan, *m_ActivePlan);
+				m_RetiredPlans.Push(std::move(plan));
+			}
+		}
+
+		if (!m_ActivePlan)
+		{
+			writeSink(nullptr);
+			return Stream<T>::Starved;
+		}
+
+		Plan& plan = *m_ActivePlan;
+		
+		{
+			NOIS_PROFILE_SCOPE_NAMED("Update Parameters");
+			
+			MarkNeededParameters(plan);
+
+			count_t numParameterSteps = static_cast<count_t>(plan.parameterSchedule.size());
+
+			// TODO: prepare when MetaParameter changes
+			for (count_t i = 0; i < numParameterSteps; ++i)
+			{
+				const ParameterStep& step = plan.parameterSchedule[i];
+				NodeRuntime& runtime = *step.runtime;
+
+				// Idle parameters are prepared too, a slot can pick them up mid-block
+				if (maxFrames != runtime.numFrames ||
+					sampleRate != runtime.sampleRate)
+				{
+					step.object->Prepare(maxFrames, sampleRate);
+					runtime.numFrames = maxFrames;
+					runtime.sampleRate = sampleRate;
+				}
+
+				if (!plan.neededParameters[i])
+				{
+					step.object->Skip(numFrames);
+					continue;
+				}
+
+				step.object->Update(numFrames);
+			}
+		}
+		
+		{
+			NOIS_PROFILE_SCOPE_NAMED("Update Streams");
+			
+			if (numFrames != plan.numFrames ||
+				numChannels != plan.numChannels)
+			{
+				// Pool buffers were allocated for the maximum, this only reallocates past it
+				for (auto& buffer : plan.bufferPool)
+				{
+					buffer.Reshape(numFrames, numChannels);
+				}
+
+				plan.numFrames = numFrames;
+				plan.numChannels = numChannels;
+			}
+			
+			for (auto& step : plan.streamSchedule)
+			{
+				NodeRuntime& runtime = *step.runtime;
+
+				if (maxFrames != runtime.numFrames ||
+					numChannels != runtime.numChannels ||
+					sampleRate != runtime.sampleRate)
+				{
+					step.object->Prepare(maxFrames, numChannels, sampleRate);
+					runtime.numFrames = maxFrames;
+					runtime.numChannels = numChannels;
+					runtime.sampleRate = sampleRate;
+				}
+
+				step.object->Update();
+				runtime.latencyFrames.store(step.object->GetLatencyFrames(), std::memory_order_relaxed);
+			}
+
+			// Latencies can change with any prepare or update
+			UpdateLatencies(plan, numChannels);
+		}
+		
+		{
+			NOIS_PROFILE_SCOPE_NAMED("Process");
+			
+			ScopedNoDenorms noDenorms;
+
+			plan.isInputSilent = inBuffer.IsSilent();
+			plan.budgetNanos = sampleRate > 0.0f ? 1e9f * static_cast<f32_t>(numFrames) / sampleRate : 0.0f;
+
+			bool isExecuted = false;
+
+			if (plan.executor && plan.streamSchedule.size() > 1)
+			{
+				plan.processInBuffer = inBuffer;
+
+				Executor::Graph graph;
+				graph.numTasks = static_cast<count_t>(plan.streamSchedule.size());
+				graph.numDependencies = plan.taskNumDependencies.data();
+				graph.dependentOffsets = plan.taskDependentOffsets.data();
+				graph.dependents = plan.taskDependents.data();
+				graph.run = &Registry::ProcessTask;
+				graph.context = &plan;
+
+				isExecuted = plan.executor->Execute(graph);
+			}
+
+			// The executor refuses graphs it wasn't reserved for, every output has its own buffer still
+			if (!isExecuted)
+			{
+				count_t numSteps = static_cast<count_t>(plan.streamSchedule.size());
+
+				for (count_t i = 0; i < numSteps; ++i)
+				{
+					ProcessStep(plan, i, inBuffer);
+				}
+			}
+			
+			writeSink(plan.sinkBuffer);
+		}
+
+		m_Timing.Record(start, plan.budgetNanos);
+
+		return plan.sinkStep >= 0 ? plan.results[plan.sinkStep] : Stream<T>::Starved;
+	}
+
+	static size_t HashTransform(bool isBlock, std::type_index type, const std::vector<const Parameter<T>*>& inputs)
+	{
+		size_t hash = std::hash<std::type_index>{}(type) * 2 + (isBlock ? 1 : 0);
+
+		for (const Parameter<T>* input : inputs)
+		{
+			hash = hash * 31 + std::hash<const void*>{}(input);
+		}
+
+		return hash;
+	}
+
+	template<typename F>
+	Ref_t<Parameter<T>> FindSharedTransform(bool isBlock, const F& transformer, const std::vector<const Parameter<T>*>& inputs) const
+	{
+		using Transformer = std::decay_t<F>;
+
+		if constexpr (std::equality_comparable<Transformer>)
+		{
+			auto [begin, end] = m_SharedTransforms.equal_range(HashTransform(isBlock, typeid(Transformer), inputs));
+
+			for (auto it = begin; it != end; ++it)
+			{
+				const SharedTransform& shared = it->second;
+
+				// Someone tuned this one for themselves, a new caller expects the defaults
+				if (shared.parameter->GetControlInterval() != Parameter<T>::k_DefaultControlInterval)
+				{
+					continue;
+				}
+
+				if (shared.isBlock == isBlock &&
+					shared.type == typeid(Transformer) &&
+					shared.inputs == inputs &&
+					shared.matches(&transformer))
+				{
+					return shared.parameter;
+				}
+			}
+		}
+
+		return nullptr;
+	}
+
+	template<typename P>
+	void ShareTransform(bool isBlock, const Ref_t<P>& parameter, std::vector<const Parameter<T>*> inputs)
+	{
+		using Transformer = std::decay_t<decltype(parameter->GetTransformer())>;
+
+		if constexpr (std::equality_comparable<Transformer>)
+		{
+			size_t hash = HashTransform(isBlock, typeid(Transformer), inputs);
+			const P* shared = parameter.get();
+
+			m_SharedTransforms.emplace(
+				hash,
+				SharedTransform{
+					isBlock,
+					typeid(Transformer),
+					std::move(inputs),
+					[shared](const void* transformer)
+					{
+						return shared->GetTransformer() == *static_cast<const Transformer*>(transformer);
+					},
+					parameter });
+		}
+	}
+
+	// Marks parameters a slot reads and everything they're transformed from
+	// Slots can be pointed elsewhere between blocks, so demand is worked out every run.
+	static void MarkNeededParameters(Plan& plan)
+	{
+		count_t numSteps = static_cast<count_t>(plan.parameterSchedule.size());
+
+		for (count_t i = 0; i < numSteps; ++i)
+		{
+			plan.neededParameters[i] = plan.parameterSchedule[i].object->IsSlotted();
+		}
+
+		// Dependencies always come earlier in the schedule, so walking back reaches all of them
+		for (count_t i = numSteps - 1; i >= 0; --i)
+		{
+			if (!plan.neededParameters[i])
+			{
+				continue;
+			}
+
+			const ParameterStep& step = plan.parameterSchedule[i];
+
+			for (count_t d = 0; d < step.numDependencies; ++d)
+			{
+				plan.neededParameters[plan.parameterDependencies[step.dependencyOffset + d]] = 1;
+			}
+		}
+	}
+
+	static void ProcessTask(void* context, count_t task)
+	{
+		auto* plan = static_cast<Plan*>(context);
+
+		ProcessStep(
+			*plan,
+			task,
+			plan->processInBuffer);
+	}
+
+	static void ProcessStep(Plan& plan, count_t index, ConstBufferView<T> inBuffer)
+	{
+		Clock::time_point start = Clock::now();
+
+		RenderStep(plan, index, inBuffer);
+
+		plan.streamSchedule[index].runtime->timing.Record(start, plan.budgetNanos);
+	}
+
+	static void RenderStep(Plan& plan, count_t index, ConstBufferView<T> inBuffer)
+	{
+		const StreamStep& step = plan.streamSchedule[index];
+		NodeRuntime& runtime = *step.runtime;
+
+		bool isInputSilent = step.numUpstreams == 0 ? plan.isInputSilent : true;
+
+		for (count_t u = 0; u < step.numUpstreams && isInputSilent; ++u)
+		{
+			isInputSilent = plan.results[plan.upstreamSteps[step.upstreamOffset + u]] == Stream<T>::Silent;
+		}
+
+		if (!isInputSilent)
+		{
+			runtime.silentFrames = 0;
+		}
+		else
+		{
+			count_t tailFrames = step.object->GetTailFrames();
+			count_t compensationFrames = plan.compensationTails[index];
+
+			// Compensation lines still hold input from before the silence
+			tailFrames = tailFrames > Stream<T>::k_InfiniteTail - compensationFrames
+				? Stream<T>::k_InfiniteTail
+				: tailFrames + compensationFrames;
+
+			if (runtime.silentFrames >= tailFrames)
+			{
+				// Nothing is left ringing, hand zeros downstream without running the stream
+				step.buffer->Zero();
+				plan.results[index] = Stream<T>::Silent;
+				return;
+			}
+
+			runtime.silentFrames += std::min(tailFrames - runtime.silentFrames, step.buffer->GetNumFrames());
+		}
+
+		if (step.mixBuffer)
+		{
+			const Buffer<T>* const* mixUpstreams = &plan.mixUpstreams[step.mixUpstreamOffset];
+
+			if (plan.compensationTails[index] == 0)
+			{
+				step.mixBuffer->Sum(*mixUpstreams[0], *mixUpstreams[1]);
+
+				for (count_t i = 2; i < step.numMixUpstreams; ++i)
+				{
+					step.mixBuffer->Add(*mixUpstreams[i]);
+				}
+			}
+			else
+			{
+				Compensation* compensations = &plan.compensations[step.mixUpstreamOffset];
+
+				step.mixBuffer->Zero();
+
+				for (count_t i = 0; i < step.numMixUpstreams; ++i)
+				{
+					if (compensations[i].numFrames == 0)
+					{
+						step.mixBuffer->Add(*mixUpstreams[i]);
+					}
+					else
+					{
+						AccumulateDelayed(*step.mixBuffer, *mixUpstreams[i], compensations[i], plan.compensationArena);
+					}
+				}
+			}
+		}
+
+		plan.results[index] = step.upstream
+			? step.object->Process(*step.upstream, *step.buffer)
+			: step.object->Process(inBuffer, *step.buffer);
+	}
+
+	// Mixes an input in through its compensation line
+	static void AccumulateDelayed(Buffer<T>& mixBuffer, const Buffer<T>& buffer, Compensation& compensation, Buffer<T>& arena)
+	{
+		count_t numFrames = std::min(mixBuffer.GetNumFrames(), buffer.GetNumFrames());
+		count_t numChannels = std::min(mixBuffer.GetNumChannels(), buffer.GetNumChannels());
+
+		for (count_t c = 0; c < numChannels; ++c)
+		{
+			T* line = arena.Data() + compensation.offset + c * compensation.numFrames;
+			count_t position = compensation.position;
+
+			for (count_t f = 0; f < numFrames; ++f)
+			{
+				T delayed = line[position];
+				line[position] = buffer(f, c);
+				mixBuffer(f, c) += delayed;
+
+				if (++position == compensation.numFrames)
+				{
+					position = 0;
+				}
+			}
+		}
+
+		compensation.position = (compensation.position + numFrames) % compensation.numFrames;
+	}
+
+	// Walks the schedule summing latencies and sizes the delay every mixed input needs
+	// The arena is only laid out again when a delay or the channel count changes, and never
+	// grown here. Delays that don't fit are dropped until Commit() compiles a bigger arena.
+	void UpdateLatencies(Plan& plan, count_t numChannels)
+	{
+		bool isLayoutDirty = ComputeLatencies(plan) || numChannels != plan.compensationChannels;
+
+		if (isLayoutDirty)
+		{
+			count_t size = LayOutCompensations(plan, numChannels);
+
+			if (size <= plan.compensationCapacity)
+			{
+				plan.compensationArena.Reshape(size, 1);
+				plan.compensationArena.Zero();
+				plan.compensationChannels = numChannels;
+			}
+			else
+			{
+				for (auto& compensation : plan.compensations)
+				{
+					compensation.numFrames = 0;
+				}
+
+				std::fill(plan.compensationTails.begin(), plan.compensationTails.end(), 0);
+				plan.compensationChannels = 0;
+				m_IsLatencyOutgrown.store(true, std::memory_order_relaxed);
+			}
+		}
+
+		m_LatencyFrames.store(GetSinkLatency(plan), std::memory_order_relaxed);
+	}
+
+	static count_t GetSinkLatency(const Plan& plan)
+	{
+		return plan.sinkStep >= 0 ? plan.latencies[plan.sinkStep] : 0;
+	}
+
+	// Copies delay lines over from the plan being swapped out
+	// Lines of edges both plans have, with the same delay, keep their contents, so an edit
+	// elsewhere in the graph doesn't leave a gap in every delayed branch.
+	static void CarryCompensations(const Plan& from, Plan& to)
+	{
+		if (from.compensationChannels != to.compensationChannels)
+		{
+			return;
+		}
+
+		for (auto& compensation : to.compensations)
+		{
+			if (compensation.numFrames == 0)
+			{
+				continue;
+			}
+
+			for (const auto& previous : from.compensations)
+			{
+				if (previous.upstream != compensation.upstream ||
+					previous.downstream != compensation.downstream)
+				{
+					continue;
+				}
+
+				if (previous.numFrames == compensation.numFrames)
+				{
+					std::copy_n(
+						from.compensationArena.Data() + previous.offset,
+						compensation.numFrames * to.compensationChannels,
+						to.compensationArena.Data() + compensation.offset);
+					compensation.position = previous.position;
+				}
+
+				break;
+			}
+		}
+	}
+
+	// Sums the latencies nodes published along the schedule, returns whether any compensating delay changed
+	static bool ComputeLatencies(Plan& plan)
+	{
+		count_t numSteps = static_cast<count_t>(plan.streamSchedule.size());
+		bool isChanged = false;
+
+		for (count_t i = 0; i < numSteps; ++i)
+		{
+			const StreamStep& step = plan.streamSchedule[i];
+			count_t inLatency = 0;
+
+			for (count_t u = 0; u < step.numUpstreams; ++u)
+			{
+				inLatency = std::max(inLatency, plan.latencies[plan.upstreamSteps[step.upstreamOffset + u]]);
+			}
+
+			plan.latencies[i] = inLatency + step.runtime->latencyFrames.load(std::memory_order_relaxed);
+
+			count_t longest = 0;
+
+			for (count_t u = 0; step.mixBuffer && u < step.numMixUpstreams; ++u)
+			{
+				Compensation& compensation = plan.compensations[step.mixUpstreamOffset + u];
+				count_t numFrames = inLatency - plan.latencies[plan.upstreamSteps[step.upstreamOffset + u]];
+
+				isChanged |= numFrames != compensation.numFrames;
+				compensation.numFrames = numFrames;
+				longest = std::max(longest, numFrames);
+			}
+
+			plan.compensationTails[i] = longest;
+		}
+
+		return isChanged;
+	}
+
+	// Puts the delay lines one after the other, returns the arena size they need
+	static count_t LayOutCompensations(Plan& plan, count_t numChannels)
+	{
+		count_t size = 0;
+
+		for (auto& compensation : plan.compensations)
+		{
+			compensation.offset = size;
+			compensation.position = 0;
+			size += compensation.numFrames * numChannels;
+		}
+
+		return size;
+	}
+
+	// Flattens the parameter and stream graphs into topologically sorted schedules
+	// Only runs when nodes or edges change, running then just steps through the arrays.
+	Own_t<Plan> Compile()
+	{
+		NOIS_PROFILE_SCOPE();
+
+		PrepareNewNodes();
+
+		auto plan = MakeOwn<Plan>();
+
+		plan->parameterSchedule.reserve(m_ParameterNodes.size());
+		plan->objects.reserve(2 * (m_ParameterNodes.size() + m_StreamNodes.size()));
+
+		for (auto& node : m_ParameterNodes)
+		{
+			node.state = NodeState::Unvisited;
+		}
+
+		for (auto& node : m_ParameterNodes)
+		{
+			ParameterCompileVisit(*plan, &node);
+		}
+
+		for (auto& node : m_ParameterNodes)
+		{
+			auto& step = plan->parameterSchedule[node.step];
+			step.dependencyOffset = static_cast<count_t>(plan->parameterDependencies.size());
+			step.numDependencies = static_cast<count_t>(node.dependencies.size());
+
+			for (auto index : node.dependencies)
+			{
+				plan->parameterDependencies.emplace_back(m_ParameterNodes[index].step);
+			}
+		}
+
+		plan->neededParameters.assign(plan->parameterSchedule.size(), 0);
+
+		plan->streamSchedule.reserve(m_StreamNodes.size());
+
+		for (auto& node : m_StreamNodes)
+		{
+			node.state = NodeState::Unvisited;
+		}
+
+		for (auto& node : m_StreamNodes)
+		{
+			StreamCompileVisit(*plan, &node);
+		}
+
+		// Queues are only grown while Run() isn't running, bigger plans stay serial
+		if (m_Executor &&
+			static_cast<count_t>(plan->streamSchedule.size()) <= m_NumExecutorTasks)
+		{
+			plan->executor = m_Executor;
+		}
+
+		CompileBuffers(*plan);
+		CompileTasks(*plan);
+		CompileCompensations(*plan);
+
+		m_IsScheduleDirty = false;
+
+		return plan;
+	}
+
+	// Prepares nodes no plan holds yet for what the graph last ran or was prepared with
+	// Otherwise a node added while audio runs would prepare, and allocate, in its first block.
+	// Nodes a plan already holds belong to the audio thread, they're never touched here.
+	void PrepareNewNodes()
+	{
+		count_t maxFrames = m_MaxNumFrames.load(std::memory_order_relaxed);
+		count_t numChannels = m_NumChannels.load(std::memory_order_relaxed);
+		f32_t sampleRate = m_SampleRate.load(std::memory_order_relaxed);
+		bool isSized = maxFrames > 0 && sampleRate > 0.0f;
+
+		for (auto& node : m_ParameterNodes)
+		{
+			NodeRuntime& runtime = *node.runtime;
+
+			if (isSized && !node.isCompiled &&
+				(maxFrames != runtime.numFrames ||
+				 sampleRate != runtime.sampleRate))
+			{
+				node.object->Prepare(maxFrames, sampleRate);
+				runtime.numFrames = maxFrames;
+				runtime.sampleRate = sampleRate;
+			}
+
+			node.isCompiled = true;
+		}
+
+		for (auto& node : m_StreamNodes)
+		{
+			NodeRuntime& runtime = *node.runtime;
+
+			if (isSized && !node.isCompiled &&
+				(maxFrames != runtime.numFrames ||
+				 numChannels != runtime.numChannels ||
+				 sampleRate != runtime.sampleRate))
+			{
+				node.object->Prepare(maxFrames, numChannels, sampleRate);
+				runtime.numFrames = maxFrames;
+				runtime.numChannels = numChannels;
+				runtime.sampleRate = sampleRate;
+			}
+
+			if (!node.isCompiled)
+			{
+				runtime.latencyFrames.store(node.object->GetLatencyFrames(), std::memory_order_relaxed);
+			}
+
+			node.isCompiled = true;
+		}
+	}
+
+	void ParameterCompileVisit(Plan& plan, ParameterNode* node)
+	{
+		// Visiting means we've hit a cycle, break it here
+		if (node->state != NodeState::Unvisited)
+		{
+			return;
+		}
+
+		node->state = NodeState::Visiting;
+
+		for (auto index : node->dependencies)
+		{
+			ParameterCompileVisit(plan, &m_ParameterNodes[index]);
+		}
+
+		ParameterStep step;
+		step.object = node->object.get();
+		step.runtime = node->runtime.get();
+
+		node->step = static_cast<count_t>(plan.parameterSchedule.size());
+		plan.parameterSchedule.emplace_back(step);
+		plan.objects.emplace_back(node->object);
+		plan.objects.emplace_back(node->runtime);
+
+		node->state = NodeState::Visited;
+	}
+	
+	void StreamCompileVisit(Plan& plan, StreamNode* node)
+	{
+		// Visiting means we've hit a cycle, break it here
+		if (node->state != NodeState::Unvisited)
+		{
+			return;
+		}
+
+		node->state = NodeState::Visiting;
+
+		for (auto index : node->dependencies)
+		{
+			StreamCompileVisit(plan, &m_StreamNodes[index]);
+		}
+
+		StreamStep step;
+		step.object = node->object.get();
+		step.runtime = node->runtime.get();
+
+		node->step = static_cast<count_t>(plan.streamSchedule.size());
+		plan.streamSchedule.emplace_back(step);
+		plan.objects.emplace_back(node->object);
+		plan.objects.emplace_back(node->runtime);
+
+		node->state = NodeState::Visited;
+	}
+
+	// Assigns node outputs and mixes to a small pool of shared buffers
+	// Works like a register allocator over the schedule, a buffer goes back to the pool
+	// once the last step reading it has run, so long chains only touch a few buffers.
+	// With an executor steps can overlap, so every output keeps a buffer of its own.
+	// Streams that support in-place processing write over their input when nothing reads it later.
+	void CompileBuffers(Plan& plan)
+	{
+		count_t numSteps = static_cast<count_t>(plan.streamSchedule.size());
+		bool canReuse = !plan.executor;
+
+		std::vector<StreamNode*> stepNodes(numSteps);
+		std::vector<count_t> lastUses(numSteps);
+		std::vector<count_t> numReaders(numSteps);
+
+		for (auto& node : m_StreamNodes)
+		{
+			stepNodes[node.step] = &node;
+			lastUses[node.step] = std::max(lastUses[node.step], node.step);
+
+			for (auto index : node.dependencies)
+			{
+				count_t upstreamStep = m_StreamNodes[index].step;
+				lastUses[upstreamStep] = std::max(lastUses[upstreamStep], node.step);
+				++numReaders[upstreamStep];
+			}
+		}
+
+		// The sink is read after every step has run
+		bool hasSink = m_SinkIndex < m_StreamNodes.size();
+
+		if (hasSink)
+		{
+			lastUses[m_StreamNodes[m_SinkIndex].step] = numSteps;
+		}
+
+		std::vector<count_t> outputs(numSteps, -1);
+		std::vector<count_t> mixes(numSteps, -1);
+		std::vector<count_t> freeBuffers;
+		count_t numBuffers = 0;
+
+		auto acquire = [&]()
+		{
+			if (freeBuffers.empty())
+			{
+				return numBuffers++;
+			}
+
+			// Most recently released first, it's the one most likely still in cache
+			count_t buffer = freeBuffers.back();
+			freeBuffers.pop_back();
+			return buffer;
+		};
+
+		auto release = [&](count_t buffer)
+		{
+			if (canReuse)
+			{
+				freeBuffers.push_back(buffer);
+			}
+		};
+
+		for (count_t i = 0; i < numSteps; ++i)
+		{
+			const StreamNode* node = stepNodes[i];
+
+			if (node->dependencies.size() > 1)
+			{
+				mixes[i] = acquire();
+			}
+
+			count_t inPlace = -1;
+
+			if (node->object->SupportsInPlace())
+			{
+				if (mixes[i] >= 0)
+				{
+					// The mix only lives for this step
+					inPlace = mixes[i];
+				}
+				else if (node->dependencies.size() == 1)
+				{
+					count_t upstreamStep = m_StreamNodes[node->dependencies.front()].step;
+
+					if (lastUses[upstreamStep] == i &&
+						(canReuse || numReaders[upstreamStep] == 1))
+					{
+						inPlace = outputs[upstreamStep];
+					}
+				}
+			}
+
+			outputs[i] = inPlace >= 0 ? inPlace : acquire();
+
+			for (auto index : node->dependencies)
+			{
+				count_t upstreamStep = m_StreamNodes[index].step;
+
+				if (lastUses[upstreamStep] == i &&
+					outputs[upstreamStep] != outputs[i])
+				{
+					release(outputs[upstreamStep]);
+				}
+			}
+
+			if (mixes[i] >= 0 &&
+				mixes[i] != outputs[i])
+			{
+				release(mixes[i]);
+			}
+
+			if (lastUses[i] == i)
+			{
+				release(outputs[i]);
+			}
+		}
+
+		// Sized for the largest block so swapping in the plan doesn't allocate
+		plan.numFrames = m_MaxNumFrames.load(std::memory_order_relaxed);
+		plan.numChannels = m_NumChannels.load(std::memory_order_relaxed);
+		plan.bufferPool.reserve(numBuffers);
+
+		for (count_t b = 0; b < numBuffers; ++b)
+		{
+			plan.bufferPool.emplace_back(plan.numFrames, plan.numChannels);
+		}
+
+		for (count_t i = 0; i < numSteps; ++i)
+		{
+			const StreamNode* node = stepNodes[i];
+			auto& step = plan.streamSchedule[i];
+
+			step.buffer = &plan.bufferPool[outputs[i]];
+			step.upstream = nullptr;
+			step.mixBuffer = nullptr;
+			step.upstreamOffset = static_cast<count_t>(plan.upstreamSteps.size());
+			step.numUpstreams = static_cast<count_t>(node->dependencies.size());
+
+			for (auto index : node->dependencies)
+			{
+				plan.upstreamSteps.emplace_back(m_StreamNodes[index].step);
+			}
+
+			if (node->dependencies.size() == 1)
+			{
+				step.upstream = &plan.bufferPool[outputs[m_StreamNodes[node->dependencies.front()].step]];
+			}
+			else if (node->dependencies.size() > 1)
+			{
+				step.mixBuffer = &plan.bufferPool[mixes[i]];
+				step.upstream = step.mixBuffer;
+				step.mixUpstreamOffset = static_cast<count_t>(plan.mixUpstreams.size());
+				step.numMixUpstreams = static_cast<count_t>(node->dependencies.size());
+
+				for (auto index : node->dependencies)
+				{
+					plan.mixUpstreams.emplace_back(&plan.bufferPool[outputs[m_StreamNodes[index].step]]);
+				}
+			}
+		}
+
+		plan.results.assign(numSteps, Stream<T>::Success);
+		plan.latencies.assign(numSteps, 0);
+		plan.compensations.assign(plan.mixUpstreams.size(), Compensation());
+		plan.compensationTails.assign(numSteps, 0);
+
+		for (const auto& step : plan.streamSchedule)
+		{
+			for (count_t u = 0; step.mixBuffer && u < step.numMixUpstreams; ++u)
+			{
+				Compensation& compensation = plan.compensations[step.mixUpstreamOffset + u];
+				compensation.upstream = plan.streamSchedule[plan.upstreamSteps[step.upstreamOffset + u]].runtime;
+				compensation.downstream = step.runtime;
+			}
+		}
+		plan.sinkStep = hasSink ? m_StreamNodes[m_SinkIndex].step : -1;
+		plan.sinkBuffer = hasSink ? &plan.bufferPool[outputs[plan.sinkStep]] : nullptr;
+	}
+
+	// Builds the dependency counts and dependent lists the executor walks
+	void CompileTasks(Plan& plan)
+	{
+		if (!plan.executor)
+		{
+			return;
+		}
+
+		count_t numTasks = static_cast<count_t>(plan.streamSchedule.size());
+
+		plan.taskNumDependencies.assign(numTasks, 0);
+		plan.taskDependentOffsets.assign(numTasks + 1, 0);
+
+		for (auto& node : m_StreamNodes)
+		{
+			plan.taskNumDependencies[node.step] = static_cast<count_t>(node.dependencies.size());
+
+			for (auto index : node.dependencies)
+			{
+				++plan.taskDependentOffsets[m_StreamNodes[index].step + 1];
+			}
+		}
+
+		for (count_t t = 0; t < numTasks; ++t)
+		{
+			plan.taskDependentOffsets[t + 1] += plan.taskDependentOffsets[t];
+		}
+
+		std::vector<count_t> cursors(plan.taskDependentOffsets.begin(), plan.taskDependentOffsets.end() - 1);
+		plan.taskDependents.resize(plan.taskDependentOffsets.back());
+
+		for (auto& node : m_StreamNodes)
+		{
+			for (auto index : node.dependencies)
+			{
+				plan.taskDependents[cursors[m_StreamNodes[index].step]++] = node.step;
+			}
+		}
+	}
+
+	// Reserves the executor with room to grow, the graph may get bigger while audio runs
+	void ReserveExecutor()
+	{
+		if (!m_Executor)
+		{
+			return;
+		}
+
+		count_t numTasks = std::max(k_MinExecutorTasks, 2 * static_cast<count_t>(m_StreamNodes.size()));
+
+		if (numTasks > m_NumExecutorTasks)
+		{
+			m_Executor->Reserve(numTasks);
+			m_NumExecutorTasks = numTasks;
+		}
+	}
+
+	// Sizes the delay arena for the latencies the nodes last published
+	void CompileCompensations(Plan& plan)
+	{
+		count_t numChannels = std::max<count_t>(m_NumChannels.load(std::memory_order_relaxed), 1);
+
+		ComputeLatencies(plan);
+
+		plan.compensationCapacity = LayOutCompensations(plan, numChannels);
+		plan.compensationArena.Resize(plan.compensationCapacity, 1);
+		plan.compensationArena.Zero();
+		plan.compensationChannels = numChannels;
+	}
+
+private:
+	// Staged graph, only touched by the control thread
+	std::vector<ParameterNode> m_ParameterNodes;
 	std::unordered_map<Ref_t<Parameter<T>>, size_t> m_ParameterLookup;
+	std::unordered_multimap<size_t, SharedTransform> m_SharedTransforms;
 	
 	std::vector<StreamNode> m_StreamNodes;
 	std::unordered_map<Ref_t<Stream<T>>, size_t> m_StreamLookup;
 	size_t m_SourceIndex;
 	size_t m_SinkIndex;
+	bool m_IsScheduleDirty;
+	Ref_t<Executor> m_Executor;
+	count_t m_NumExecutorTasks;
+
+	// Hand-over between the control and audio threads
+	std::atomic<Plan*> m_PendingPlan;
+	SpscQueue<Own_t<Plan>> m_RetiredPlans;
+	std::atomic<bool> m_IsLatencyOutgrown;
+
+	// Only touched by the audio thread
+	Own_t<Plan> m_ActivePlan;
+	Buffer<T> m_HostBuffer;
+	std::atomic<count_t> m_MaxNumFrames;
+	std::atomic<bool> m_IsMaxPrepared;
+	std::atomic<count_t> m_NumChannels;
+	std::atomic<f32_t> m_SampleRate;
+	std::atomic<count_t> m_LatencyFrames;
+	TimingCounters m_Timing;
 };
 
 } // namespace nois
@@ -3,6 +3,8 @@
 #include "nois/NoisTypes.hpp"
 #include "nois/core/NoisBuffer.hpp"
 
+#include <limits>
+
 namespace nois {
 
 template<typename T>
@@ -17,13 +19,18 @@ public:
 	enum Result
 	{
 		Success,
+		// Succeeded and every output sample is zero
+		Silent,
 		Starved,
 		Failure
 	};
+
+	static constexpr count_t k_InfiniteTail = std::numeric_limits<count_t>::max();
 	
 public:
 	virtual ~Stream() {}
 
+	// Called with the largest block Process() will be handed, blocks can be shorter
 	virtual void Prepare(
 		count_t numFrames,
 		count_t numChannels,
@@ -34,6 +41,18 @@ public:
 	virtual Result Process(
 		ConstBufferView<T> inBuffer,
 		BufferView<T> outBuffer) = 0;
+
+	// Whether Process() may be handed the same memory as input and output
+	// Only say so when every output sample is written after the input it depends on is read.
+	virtual bool SupportsInPlace() const { return false; }
+
+	// Frames the output keeps ringing once the input goes silent
+	// The registry skips the stream after that, generators should keep the infinite default.
+	virtual count_t GetTailFrames() const { return k_InfiniteTail; }
+
+	// Frames the output lags behind the input
+	// The registry delays parallel branches so they still line up where they join.
+	virtual count_t GetLatencyFrames() const { return 0; }
 	
 private:
 	Registry<T>* mRegistry = nullptr;
@@ -9,6 +9,8 @@ class Compressor : public Stream<f32_t>
 {
 public:
 	NOIS_INTERFACE(Compressor)
+	NOIS_INTERFACE_INPLACE()
+	NOIS_INTERFACE_TAIL()
 	NOIS_INTERFACE_PARAM(Ratio, FloatBlockParameter)
 	NOIS_INTERFACE_PARAM(ThresholdDb, FloatBlockParameter)
 	NOIS_INTERFACE_PARAM(AttackMs, FloatBlockParameter)
@@ -8,6 +8,8 @@ class DynamicTanhDistorter : public Stream<f32_t>
 {
 public:
 	NOIS_INTERFACE(DynamicTanhDistorter)
+	NOIS_INTERFACE_INPLACE()
+	NOIS_INTERFACE_NO_TAIL()
 	NOIS_INTERFACE_PARAM(DriveDb, FloatBlockParameter)
 	NOIS_INTERFACE_PARAM(MakeupDb, FloatBlockParameter)
 	NOIS_INTERFACE_PARAM(Wet, FloatBlockParameter)
@@ -9,6 +9,8 @@ class Gainer : public Stream<f32_t>
 {
 public:
 	NOIS_INTERFACE(Gainer)
+	NOIS_INTERFACE_INPLACE()
+	NOIS_INTERFACE_NO_TAIL()
 	NOIS_INTERFACE_PARAM(Gain, FloatParameter)
 };
 
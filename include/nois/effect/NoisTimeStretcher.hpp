@@ -12,6 +12,8 @@ class TimeStretcher : public Stream<f32_t>
 {
 public:
 	NOIS_INTERFACE(TimeStretcher)
+	NOIS_INTERFACE_INPLACE()
+	NOIS_INTERFACE_TAIL()
 	NOIS_INTERFACE_PARAM(StretchTimeMs, FloatParameter)
 	NOIS_INTERFACE_PARAM(StretchActive, FloatParameter)
 	NOIS_INTERFACE_PARAM(StretchFactor, FloatParameter)
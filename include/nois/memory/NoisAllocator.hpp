@@ -43,4 +43,52 @@ struct Allocator
 	}
 };
 
+// Allocator aligning every block to Alignment
+// Over-allocates through Malloc() and keeps the original pointer right in front of the block.
+template<typename T, size_t Alignment>
+struct AlignedAllocator
+{
+	using value_type = T;
+
+	template<typename U>
+	struct rebind
+	{
+		using other = AlignedAllocator<U, Alignment>;
+	};
+
+	AlignedAllocator() = default;
+
+	template<typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept
+	{
+	}
+
+	value_type* allocate(size_t n)
+	{
+		void* ptr = Malloc(sizeof(value_type) * n + Alignment + sizeof(void*));
+		uintptr_t aligned = (reinterpret_cast<uintptr_t>(ptr) + sizeof(void*) + Alignment - 1) & ~static_cast<uintptr_t>(Alignment - 1);
+
+		reinterpret_cast<void**>(aligned)[-1] = ptr;
+
+		return reinterpret_cast<value_type*>(aligned);
+	}
+
+	void deallocate(value_type* ptr, size_t n)
+	{
+		Free(reinterpret_cast<void**>(ptr)[-1]);
+	}
+
+	template<typename U>
+	bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept
+	{
+		return true;
+	}
+
+	template<typename U>
+	bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept
+	{
+		return false;
+	}
+};
+
 }
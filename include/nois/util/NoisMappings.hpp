@@ -0,0 +1,194 @@
+#pragma once
+
+#include "nois/NoisTypes.hpp"
+#include "nois/core/NoisParameter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if NOIS_ARCH_X64
+#include <emmintrin.h>
+#endif // NOIS_ARCH_X64
+
+// Block mappings
+// Unit conversions for Parameter::TransformBlock(), each one fills a whole block
+// from a single input span and runs four frames at a time where SSE2 is available.
+// Equal mappings of the same parameter resolve to one shared parameter.
+namespace nois::mapping {
+
+namespace detail {
+
+// Cephes exp2 polynomial, accurate to about 2e-7 relative over the float range
+inline f32_t Exp2(f32_t x)
+{
+	x = std::clamp(x, -126.0f, 127.0f);
+	f32_t n = std::nearbyint(x);
+	f32_t r = x - n;
+	f32_t p = 1.535336188319500e-4f;
+	p = p * r + 1.339887440266574e-3f;
+	p = p * r + 9.618437357674640e-3f;
+	p = p * r + 5.550332471162809e-2f;
+	p = p * r + 2.402264791363012e-1f;
+	p = p * r + 6.931472028550421e-1f;
+	p = p * r + 1.0f;
+	return std::ldexp(p, static_cast<int>(n));
+}
+
+#if NOIS_ARCH_X64
+inline __m128 Exp2(__m128 x)
+{
+	x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(127.0f));
+	__m128i n = _mm_cvtps_epi32(x);
+	__m128 r = _mm_sub_ps(x, _mm_cvtepi32_ps(n));
+	__m128 p = _mm_set1_ps(1.535336188319500e-4f);
+	p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.339887440266574e-3f));
+	p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(9.618437357674640e-3f));
+	p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(5.550332471162809e-2f));
+	p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(2.402264791363012e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(6.931472028550421e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.0f));
+	// Scale by 2^n straight in the exponent bits
+	__m128i bits = _mm_add_epi32(_mm_castps_si128(p), _mm_slli_epi32(n, 23));
+	return _mm_castsi128_ps(bits);
+}
+#endif // NOIS_ARCH_X64
+
+// Runs scalar(x) and vector(x) over the span
+// Constant spans are mapped once and broadcast.
+template<typename S, typename V>
+inline void Map(f32_t* out, count_t numFrames, const BlockSpan<f32_t>& in, S&& scalar, V&& vector)
+{
+	if (numFrames <= 0)
+	{
+		return;
+	}
+
+	if (in.IsConstant())
+	{
+		std::fill_n(out, numFrames, scalar(in.values[0]));
+		return;
+	}
+
+	const f32_t* values = in.values;
+	count_t f = 0;
+
+#if NOIS_ARCH_X64
+	if (in.stride == 1)
+	{
+		for (; f + 4 <= numFrames; f += 4)
+		{
+			_mm_storeu_ps(out + f, vector(_mm_loadu_ps(values + f)));
+		}
+	}
+#endif // NOIS_ARCH_X64
+
+	for (; f < numFrames; ++f)
+	{
+		out[f] = scalar(in[f]);
+	}
+}
+
+}
+
+// scale * x + offset
+struct ScaleOffset
+{
+	f32_t scale = 1.0f;
+	f32_t offset = 0.0f;
+
+	bool operator==(const ScaleOffset&) const = default;
+
+	void operator()(f32_t* out, count_t numFrames, const BlockSpan<f32_t>& in) const
+	{
+		detail::Map(
+			out, numFrames, in,
+			[this](f32_t x) { return scale * x + offset; }
+#if NOIS_ARCH_X64
+			, [s = _mm_set1_ps(scale), o = _mm_set1_ps(offset)](__m128 x) { return _mm_add_ps(_mm_mul_ps(s, x), o); }
+#else
+			, nullptr
+#endif // NOIS_ARCH_X64
+			);
+	}
+};
+
+// Decibels to linear gain
+struct DbToLinear
+{
+	bool operator==(const DbToLinear&) const = default;
+
+	void operator()(f32_t* out, count_t numFrames, const BlockSpan<f32_t>& in) const
+	{
+		// 10^(x / 20) = 2^(x * log2(10) / 20)
+		constexpr f32_t k_Log2Ten20 = 0.166096404744368f;
+
+		detail::Map(
+			out, numFrames, in,
+			[](f32_t x) { return detail::Exp2(x * k_Log2Ten20); }
+#if NOIS_ARCH_X64
+			, [k = _mm_set1_ps(k_Log2Ten20)](__m128 x) { return detail::Exp2(_mm_mul_ps(x, k)); }
+#else
+			, nullptr
+#endif // NOIS_ARCH_X64
+			);
+	}
+};
+
+// Normalized [0, 1] to an exponential [min, max] range, both must be positive
+struct ExpRange
+{
+	f32_t min = 20.0f;
+	f32_t max = 20000.0f;
+
+	bool operator==(const ExpRange&) const = default;
+
+	void operator()(f32_t* out, count_t numFrames, const BlockSpan<f32_t>& in) const
+	{
+		f32_t octaves = std::log2(max / min);
+
+		detail::Map(
+			out, numFrames, in,
+			[this, octaves](f32_t x) { return min * detail::Exp2(x * octaves); }
+#if NOIS_ARCH_X64
+			, [lo = _mm_set1_ps(min), k = _mm_set1_ps(octaves)](__m128 x) { return _mm_mul_ps(lo, detail::Exp2(_mm_mul_ps(x, k))); }
+#else
+			, nullptr
+#endif // NOIS_ARCH_X64
+			);
+	}
+};
+
+// Milliseconds to frames at the parameter's sample rate
+struct MsToFrames
+{
+	bool operator==(const MsToFrames&) const = default;
+
+	void operator()(f32_t* out, count_t numFrames, const BlockSpan<f32_t>& in, f32_t sampleRate) const
+	{
+		ScaleOffset{ 0.001f * sampleRate, 0.0f }(out, numFrames, in);
+	}
+};
+
+// Clamps x to [min, max]
+struct Clamp
+{
+	f32_t min = 0.0f;
+	f32_t max = 1.0f;
+
+	bool operator==(const Clamp&) const = default;
+
+	void operator()(f32_t* out, count_t numFrames, const BlockSpan<f32_t>& in) const
+	{
+		detail::Map(
+			out, numFrames, in,
+			[this](f32_t x) { return std::clamp(x, min, max); }
+#if NOIS_ARCH_X64
+			, [lo = _mm_set1_ps(min), hi = _mm_set1_ps(max)](__m128 x) { return _mm_min_ps(_mm_max_ps(x, lo), hi); }
+#else
+			, nullptr
+#endif // NOIS_ARCH_X64
+			);
+	}
+};
+
+}
@@ -0,0 +1,333 @@
+#pragma once
+
+#include "nois/NoisTypes.hpp"
+#include "nois/NoisConfig.hpp"
+#include "nois/core/NoisParameter.hpp"
+#include "nois/memory/NoisAllocator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if NOIS_ARCH_X64
+#include <emmintrin.h>
+#endif // NOIS_ARCH_X64
+
+namespace nois {
+
+// Smoothing bank
+// Smooths many parameters together, four lanes per SIMD quad, written frame by frame
+// into one interleaved block so every lane is a strided span. Quads whose lanes have all
+// settled on a constant target are skipped, a settled lane costs one target read per block.
+class SmoothingBank
+{
+public:
+	enum class Ramp : uint8_t
+	{
+		// Exponential approach, timeSec is the time constant
+		OnePole,
+		// Straight line to each new target, timeSec is the ramp length
+		Linear
+	};
+
+	static constexpr count_t k_QuadLanes = 4;
+	// Lanes this close to a constant target snap to it and settle
+	static constexpr f32_t k_SettleTolerance = 1e-6f;
+
+public:
+	// Drops every lane, only call while not processing
+	void Clear()
+	{
+		m_Lanes.clear();
+		m_NumLanes = 0;
+	}
+
+	// Adds a lane smoothing target, returns its index
+	count_t Add(Ref_t<IBlockReader<f32_t>> target, f32_t timeSec, Ramp ramp = Ramp::OnePole)
+	{
+		m_Lanes.push_back({ std::move(target), timeSec, ramp });
+		return m_NumLanes++;
+	}
+
+	// Allocates for maxFrames, call after adding lanes and whenever the rate changes
+	void Prepare(count_t maxFrames, f32_t sampleRate)
+	{
+		m_NumQuads = (m_NumLanes + k_QuadLanes - 1) / k_QuadLanes;
+		m_Stride = m_NumQuads * k_QuadLanes;
+		m_MaxFrames = std::max<count_t>(maxFrames, 1);
+
+		m_Interleaved.assign(m_MaxFrames * m_Stride, 0.0f);
+		m_Value.assign(m_Stride, 0.0f);
+		m_Target.assign(m_Stride, 0.0f);
+		m_Coeff.assign(m_Stride, 0.0f);
+		m_Step.assign(m_Stride, 0.0f);
+		m_Remaining.assign(m_Stride, 0.0f);
+		m_IsLinear.assign(m_Stride, 0.0f);
+		m_Spans.assign(m_Stride, BlockSpan<f32_t>{});
+		m_Targets.assign(m_Stride, BlockSpan<f32_t>{});
+
+		for (count_t l = 0; l < m_NumLanes; ++l)
+		{
+			Lane& lane = m_Lanes[l];
+			f32_t numFrames = std::max(lane.timeSec * sampleRate, 1.0f);
+
+			m_Coeff[l] = 1.0f - std::exp(-1.0f / numFrames);
+			m_IsLinear[l] = lane.ramp == Ramp::Linear ? 1.0f : 0.0f;
+			lane.rampFrames = std::round(numFrames);
+			lane.isInitialized = false;
+			lane.isSettled = true;
+		}
+	}
+
+	// Reads every target and smooths numFrames of each lane that is still moving
+	void Process(count_t numFrames)
+	{
+		NOIS_PROFILE_SCOPE();
+
+		numFrames = std::min(numFrames, m_MaxFrames);
+		m_NumActive = 0;
+
+		for (count_t q = 0; q < m_NumQuads; ++q)
+		{
+			bool isActive = false;
+			bool isConstant = true;
+
+			for (count_t l = q * k_QuadLanes; l < std::min(m_NumLanes, (q + 1) * k_QuadLanes); ++l)
+			{
+				BlockSpan<f32_t> target = m_Lanes[l].target->Span();
+				isActive = Retarget(l, target) || isActive;
+				isConstant = isConstant && target.IsConstant();
+				m_Targets[l] = target;
+			}
+
+			if (!isActive)
+			{
+				continue;
+			}
+
+			if (isConstant)
+			{
+				ProcessQuad(q, numFrames);
+			}
+			else
+			{
+				for (count_t l = q * k_QuadLanes; l < (q + 1) * k_QuadLanes; ++l)
+				{
+					ProcessLane(l, numFrames);
+				}
+			}
+		}
+
+		for (count_t l = 0; l < m_NumLanes; ++l)
+		{
+			Settle(l, numFrames);
+		}
+	}
+
+	// Valid until the next Process()
+	const BlockSpan<f32_t>& Span(count_t lane) const
+	{
+		return m_Spans[lane];
+	}
+
+	bool IsSettled(count_t lane) const
+	{
+		return m_Lanes[lane].isSettled;
+	}
+
+	// Lanes that moved in the last Process()
+	count_t GetNumActive() const
+	{
+		return m_NumActive;
+	}
+
+private:
+	struct Lane
+	{
+		Ref_t<IBlockReader<f32_t>> target = nullptr;
+		f32_t timeSec = 0.0f;
+		Ramp ramp = Ramp::OnePole;
+		f32_t rampFrames = 1.0f;
+		bool isInitialized = false;
+		bool isSettled = true;
+		bool isMoving = false;
+	};
+
+	// Picks up a new target at the start of a block, returns whether the lane has to move
+	bool Retarget(count_t l, const BlockSpan<f32_t>& target)
+	{
+		Lane& lane = m_Lanes[l];
+		f32_t goal = target.values[0];
+
+		if (!lane.isInitialized)
+		{
+			m_Value[l] = goal;
+			m_Target[l] = goal;
+			lane.isInitialized = true;
+		}
+
+		if (lane.isSettled && target.IsConstant() && goal == m_Value[l])
+		{
+			lane.isMoving = false;
+			return false;
+		}
+
+		if (target.IsConstant())
+		{
+			SetTarget(l, goal);
+		}
+
+		lane.isSettled = false;
+		lane.isMoving = true;
+		return true;
+	}
+
+	void SetTarget(count_t l, f32_t goal)
+	{
+		if (goal == m_Target[l])
+		{
+			return;
+		}
+
+		m_Target[l] = goal;
+
+		if (m_IsLinear[l] != 0.0f)
+		{
+			m_Remaining[l] = m_Lanes[l].rampFrames;
+			m_Step[l] = (goal - m_Value[l]) / m_Remaining[l];
+		}
+	}
+
+	// One frame of one lane, the scalar twin of the quad kernel
+	f32_t Advance(count_t l)
+	{
+		f32_t value = m_Value[l];
+
+		if (m_IsLinear[l] != 0.0f)
+		{
+			m_Remaining[l] = std::max(m_Remaining[l] - 1.0f, 0.0f);
+			value = m_Remaining[l] > 0.0f ? value + m_Step[l] : m_Target[l];
+		}
+		else
+		{
+			value += (m_Target[l] - value) * m_Coeff[l];
+		}
+
+		m_Value[l] = value;
+		return value;
+	}
+
+	void ProcessQuad(count_t q, count_t numFrames)
+	{
+		count_t base = q * k_QuadLanes;
+		f32_t* out = m_Interleaved.data() + base;
+
+#if NOIS_ARCH_X64
+		__m128 value = _mm_load_ps(m_Value.data() + base);
+		__m128 target = _mm_load_ps(m_Target.data() + base);
+		__m128 coeff = _mm_load_ps(m_Coeff.data() + base);
+		__m128 step = _mm_load_ps(m_Step.data() + base);
+		__m128 remaining = _mm_load_ps(m_Remaining.data() + base);
+		__m128 isLinear = _mm_cmpneq_ps(_mm_load_ps(m_IsLinear.data() + base), _mm_setzero_ps());
+		__m128 zero = _mm_setzero_ps();
+		__m128 one = _mm_set1_ps(1.0f);
+
+		for (count_t f = 0; f < numFrames; ++f)
+		{
+			__m128 onePole = _mm_add_ps(value, _mm_mul_ps(_mm_sub_ps(target, value), coeff));
+
+			remaining = _mm_max_ps(_mm_sub_ps(remaining, one), zero);
+			__m128 isRamping = _mm_cmpgt_ps(remaining, zero);
+			__m128 linear = _mm_or_ps(
+				_mm_and_ps(isRamping, _mm_add_ps(value, step)),
+				_mm_andnot_ps(isRamping, target));
+
+			value = _mm_or_ps(_mm_and_ps(isLinear, linear), _mm_andnot_ps(isLinear, onePole));
+			_mm_storeu_ps(out + f * m_Stride, value);
+		}
+
+		_mm_store_ps(m_Value.data() + base, value);
+		_mm_store_ps(m_Remaining.data() + base, remaining);
+#else
+		for (count_t f = 0; f < numFrames; ++f)
+		{
+			for (count_t i = 0; i < k_QuadLanes; ++i)
+			{
+				out[f * m_Stride + i] = Advance(base + i);
+			}
+		}
+#endif // NOIS_ARCH_X64
+	}
+
+	// Targets that move within the block are followed frame by frame
+	void ProcessLane(count_t l, count_t numFrames)
+	{
+		if (l >= m_NumLanes)
+		{
+			return;
+		}
+
+		const BlockSpan<f32_t>& target = m_Targets[l];
+		f32_t* out = m_Interleaved.data() + l;
+
+		for (count_t f = 0; f < numFrames; ++f)
+		{
+			if (!target.IsConstant())
+			{
+				SetTarget(l, target[std::min(f, target.numFrames - 1)]);
+			}
+
+			out[f * m_Stride] = Advance(l);
+		}
+	}
+
+	// Hands out the lane's span and snaps it once close enough to a constant target
+	void Settle(count_t l, count_t numFrames)
+	{
+		Lane& lane = m_Lanes[l];
+		const BlockSpan<f32_t>& target = m_Targets[l];
+
+		if (!lane.isMoving)
+		{
+			m_Spans[l] = { m_Value.data() + l, 0, numFrames, target.changed };
+			return;
+		}
+
+		++m_NumActive;
+		m_Spans[l] = { m_Interleaved.data() + l, m_Stride, numFrames, true, nullptr, BlockShape::Arbitrary };
+
+		f32_t goal = m_Target[l];
+		f32_t tolerance = k_SettleTolerance * std::max(std::abs(goal), 1.0f);
+
+		if (target.IsConstant() &&
+			m_Remaining[l] <= 0.0f &&
+			std::abs(goal - m_Value[l]) <= tolerance)
+		{
+			m_Value[l] = goal;
+			lane.isSettled = true;
+		}
+	}
+
+private:
+	std::vector<Lane> m_Lanes;
+	count_t m_NumLanes = 0;
+	count_t m_NumQuads = 0;
+	count_t m_Stride = 0;
+	count_t m_MaxFrames = 0;
+	count_t m_NumActive = 0;
+
+	// Frame-major, frame f of lane l lives at f * m_Stride + l
+	std::vector<f32_t, AlignedAllocator<f32_t, k_SimdAlignment>> m_Interleaved;
+
+	// Per lane state, padded to whole quads
+	std::vector<f32_t, AlignedAllocator<f32_t, k_SimdAlignment>> m_Value;
+	std::vector<f32_t, AlignedAllocator<f32_t, k_SimdAlignment>> m_Target;
+	std::vector<f32_t, AlignedAllocator<f32_t, k_SimdAlignment>> m_Coeff;
+	std::vector<f32_t, AlignedAllocator<f32_t, k_SimdAlignment>> m_Step;
+	std::vector<f32_t, AlignedAllocator<f32_t, k_SimdAlignment>> m_Remaining;
+	std::vector<f32_t, AlignedAllocator<f32_t, k_SimdAlignment>> m_IsLinear;
+	std::vector<BlockSpan<f32_t>> m_Spans;
+	std::vector<BlockSpan<f32_t>> m_Targets;
+};
+
+}
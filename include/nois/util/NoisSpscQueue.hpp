@@ -0,0 +1,81 @@
+#pragma once
+
+#include "nois/NoisTypes.hpp"
+#include "nois/NoisConfig.hpp"
+
+#include <atomic>
+#include <vector>
+
+namespace nois {
+
+// Single producer single consumer ring
+// Wait-free on both ends, storage is allocated up front so pushing never allocates.
+template<typename T>
+class SpscQueue
+{
+public:
+	SpscQueue(count_t capacity = 0)
+	{
+		Reserve(capacity);
+	}
+
+	// Only call while neither end is in use
+	void Reserve(count_t capacity)
+	{
+		// One slot is always left empty to tell full from empty
+		m_Slots.clear();
+		m_Slots.resize(capacity + 1);
+		m_Head.store(0, std::memory_order_relaxed);
+		m_Tail.store(0, std::memory_order_relaxed);
+	}
+
+	// Producer side
+	bool CanPush() const
+	{
+		size_t tail = m_Tail.load(std::memory_order_relaxed);
+		return Next(tail) != m_Head.load(std::memory_order_acquire);
+	}
+
+	bool Push(T&& value)
+	{
+		size_t tail = m_Tail.load(std::memory_order_relaxed);
+		size_t next = Next(tail);
+
+		if (next == m_Head.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		m_Slots[tail] = std::move(value);
+		m_Tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side
+	bool Pop(T& value)
+	{
+		size_t head = m_Head.load(std::memory_order_relaxed);
+
+		if (head == m_Tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		value = std::move(m_Slots[head]);
+		m_Head.store(Next(head), std::memory_order_release);
+		return true;
+	}
+
+private:
+	size_t Next(size_t index) const
+	{
+		return index + 1 == m_Slots.size() ? 0 : index + 1;
+	}
+
+private:
+	std::vector<T> m_Slots;
+	alignas(kCacheLineSize) std::atomic<size_t> m_Head = 0;
+	alignas(kCacheLineSize) std::atomic<size_t> m_Tail = 0;
+};
+
+}
@@ -31,6 +31,12 @@
 		return m_Impl->Process(inBuffer, outBuffer); \
 	}
 
+#define NOIS_INTERFACE_TAIL_IMPL(_class) \
+	count_t _class::GetTailFrames() const \
+	{ \
+		return m_Impl->GetTailFrames(); \
+	}
+
 #define NOIS_INTERFACE_PARAM_IMPL(_class, _name, _type) \
 	void _class::Set##_name(Ref_t<_type> value) \
 	{ \
@@ -0,0 +1,360 @@
+#include "nois/core/NoisExecutor.hpp"
+
+#include "nois/NoisUtil.hpp"
+
+#include <thread>
+
+#if NOIS_TARGET_WINDOWS
+#include <windows.h>
+#elif NOIS_TARGET_LINUX || NOIS_TARGET_MAC || NOIS_TARGET_IOS
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace nois {
+
+namespace {
+
+inline void PromoteToRealtime(std::thread& thread)
+{
+	// Best effort, we keep running at normal priority if the OS refuses
+#if NOIS_TARGET_WINDOWS
+	SetThreadPriority(thread.native_handle(), THREAD_PRIORITY_TIME_CRITICAL);
+#elif NOIS_TARGET_LINUX || NOIS_TARGET_MAC || NOIS_TARGET_IOS
+	sched_param param = {};
+	param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+	pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &param);
+#endif // NOIS_TARGET_WINDOWS + NOIS_TARGET_LINUX + NOIS_TARGET_MAC + NOIS_TARGET_IOS
+}
+
+}
+
+// Chase-Lev work-stealing deque
+// The owner pushes and pops at the bottom, thieves steal from the top.
+// Capacity is fixed up front so no allocation happens while executing.
+class WorkDeque
+{
+public:
+	void Reserve(count_t capacity)
+	{
+		ucount_t realCapacity = 1;
+
+		while (realCapacity < static_cast<ucount_t>(capacity))
+		{
+			realCapacity <<= 1;
+		}
+
+		m_Tasks = MakeOwn<std::atomic<count_t>[]>(realCapacity);
+		m_Mask = realCapacity - 1;
+		m_Top.store(0, std::memory_order_relaxed);
+		m_Bottom.store(0, std::memory_order_relaxed);
+	}
+
+	void Push(count_t task)
+	{
+		s64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+		m_Tasks[bottom & m_Mask].store(task, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	bool Pop(count_t& task)
+	{
+		s64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+		m_Bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		s64_t top = m_Top.load(std::memory_order_relaxed);
+
+		if (top > bottom)
+		{
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		task = m_Tasks[bottom & m_Mask].load(std::memory_order_relaxed);
+
+		if (top == bottom)
+		{
+			// Last task, race the thieves for it
+			bool won = m_Top.compare_exchange_strong(
+				top,
+				top + 1,
+				std::memory_order_seq_cst,
+				std::memory_order_relaxed);
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+			return won;
+		}
+
+		return true;
+	}
+
+	bool Steal(count_t& task)
+	{
+		s64_t top = m_Top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		s64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+		if (top >= bottom)
+		{
+			return false;
+		}
+
+		task = m_Tasks[top & m_Mask].load(std::memory_order_relaxed);
+
+		return m_Top.compare_exchange_strong(
+			top,
+			top + 1,
+			std::memory_order_seq_cst,
+			std::memory_order_relaxed);
+	}
+
+private:
+	alignas(kCacheLineSize) std::atomic<s64_t> m_Top = 0;
+	alignas(kCacheLineSize) std::atomic<s64_t> m_Bottom = 0;
+	Own_t<std::atomic<count_t>[]> m_Tasks = nullptr;
+	s64_t m_Mask = 0;
+};
+
+class Executor::Impl
+{
+public:
+	Impl(count_t numWorkers)
+		: m_Deques(numWorkers + 1)
+	{
+		m_Threads.reserve(numWorkers);
+
+		for (count_t i = 0; i < numWorkers; ++i)
+		{
+			m_Threads.emplace_back(
+				[this, i]()
+				{
+					WorkerLoop(i + 1);
+				});
+			PromoteToRealtime(m_Threads.back());
+		}
+	}
+
+	~Impl()
+	{
+		m_IsQuitting.store(true, std::memory_order_seq_cst);
+		m_Generation.fetch_add(1, std::memory_order_seq_cst);
+		m_Generation.notify_all();
+
+		for (auto& thread : m_Threads)
+		{
+			thread.join();
+		}
+	}
+
+	void Reserve(count_t numTasks)
+	{
+		// Holds the executor like Execute() does, so no graph runs on the queues being replaced
+		while (m_IsBusy.exchange(true, std::memory_order_acquire))
+		{
+			std::this_thread::yield();
+		}
+
+		if (numTasks > m_NumReservedTasks)
+		{
+			for (auto& deque : m_Deques)
+			{
+				deque.Reserve(numTasks);
+			}
+
+			m_Pending = MakeOwn<std::atomic<count_t>[]>(numTasks);
+			m_NumReservedTasks = numTasks;
+		}
+
+		m_IsBusy.store(false, std::memory_order_release);
+	}
+
+	bool Execute(const Graph& graph)
+	{
+		NOIS_PROFILE_SCOPE();
+
+		if (graph.numTasks <= 0)
+		{
+			return true;
+		}
+
+		// Graph, counts and queues are shared, a second caller would corrupt them
+		if (m_IsBusy.exchange(true, std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		// Growing the queues here could free them under a worker, refuse instead
+		if (graph.numTasks > m_NumReservedTasks)
+		{
+			m_IsBusy.store(false, std::memory_order_release);
+			return false;
+		}
+
+		// Wait out any worker still leaving the previous graph
+		WaitForIdleWorkers();
+
+		m_Graph = &graph;
+		m_Remaining.store(graph.numTasks, std::memory_order_relaxed);
+
+		for (count_t t = 0; t < graph.numTasks; ++t)
+		{
+			m_Pending[t].store(graph.numDependencies[t], std::memory_order_relaxed);
+		}
+
+		// The calling thread seeds the roots, idle workers steal them
+		for (count_t t = 0; t < graph.numTasks; ++t)
+		{
+			if (graph.numDependencies[t] == 0)
+			{
+				m_Deques[0].Push(t);
+			}
+		}
+
+		m_IsRunning.store(true, std::memory_order_seq_cst);
+		m_Generation.fetch_add(1, std::memory_order_seq_cst);
+		m_Generation.notify_all();
+
+		Work(0);
+
+		m_IsRunning.store(false, std::memory_order_seq_cst);
+
+		WaitForIdleWorkers();
+
+		m_IsBusy.store(false, std::memory_order_release);
+
+		return true;
+	}
+
+	count_t GetNumWorkers() const
+	{
+		return static_cast<count_t>(m_Threads.size());
+	}
+
+private:
+	void WorkerLoop(count_t index)
+	{
+		u64_t seen = 0;
+
+		for (;;)
+		{
+			m_Generation.wait(seen, std::memory_order_seq_cst);
+
+			if (m_IsQuitting.load(std::memory_order_seq_cst))
+			{
+				break;
+			}
+
+			m_NumActive.fetch_add(1, std::memory_order_seq_cst);
+
+			u64_t generation = m_Generation.load(std::memory_order_seq_cst);
+
+			if (generation != seen &&
+				m_IsRunning.load(std::memory_order_seq_cst))
+			{
+				ScopedNoDenorms noDenorms;
+
+				Work(index);
+			}
+
+			seen = generation;
+
+			m_NumActive.fetch_sub(1, std::memory_order_seq_cst);
+		}
+	}
+
+	void Work(count_t index)
+	{
+		const Graph& graph = *m_Graph;
+		count_t numDeques = static_cast<count_t>(m_Deques.size());
+
+		while (m_Remaining.load(std::memory_order_acquire) > 0)
+		{
+			count_t task = -1;
+			bool found = m_Deques[index].Pop(task);
+
+			for (count_t i = 1; !found && i < numDeques; ++i)
+			{
+				found = m_Deques[(index + i) % numDeques].Steal(task);
+			}
+
+			if (!found)
+			{
+				CpuRelax();
+				continue;
+			}
+
+			graph.run(graph.context, task);
+
+			for (count_t d = graph.dependentOffsets[task]; d < graph.dependentOffsets[task + 1]; ++d)
+			{
+				count_t dependent = graph.dependents[d];
+
+				if (m_Pending[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					m_Deques[index].Push(dependent);
+				}
+			}
+
+			m_Remaining.fetch_sub(1, std::memory_order_acq_rel);
+		}
+	}
+
+	void WaitForIdleWorkers()
+	{
+		while (m_NumActive.load(std::memory_order_seq_cst) != 0)
+		{
+			CpuRelax();
+		}
+	}
+
+private:
+	std::vector<std::thread> m_Threads;
+	std::vector<WorkDeque> m_Deques;
+	Own_t<std::atomic<count_t>[]> m_Pending = nullptr;
+	count_t m_NumReservedTasks = 0;
+	const Graph* m_Graph = nullptr;
+
+	alignas(kCacheLineSize) std::atomic<count_t> m_Remaining = 0;
+	alignas(kCacheLineSize) std::atomic<count_t> m_NumActive = 0;
+	alignas(kCacheLineSize) std::atomic<u64_t> m_Generation = 0;
+	std::atomic<bool> m_IsRunning = false;
+	std::atomic<bool> m_IsQuitting = false;
+	// Held by the one thread executing or reserving
+	std::atomic<bool> m_IsBusy = false;
+};
+
+Executor::Executor(Own_t<Impl> impl)
+	: m_Impl(std::move(impl))
+{
+}
+
+Executor::~Executor()
+{
+}
+
+Ref_t<Executor> Executor::Create(count_t numWorkers)
+{
+	if (numWorkers <= 0)
+	{
+		numWorkers = std::max<count_t>(static_cast<count_t>(std::thread::hardware_concurrency()) - 1, 1);
+	}
+
+	return MakeRef<Executor>(MakeOwn<Impl>(numWorkers));
+}
+
+void Executor::Reserve(count_t numTasks)
+{
+	m_Impl->Reserve(numTasks);
+}
+
+bool Executor::Execute(const Graph& graph)
+{
+	return m_Impl->Execute(graph);
+}
+
+count_t Executor::GetNumWorkers() const
+{
+	return m_Impl->GetNumWorkers();
+}
+
+}
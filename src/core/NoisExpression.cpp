@@ -0,0 +1,807 @@
+#include "nois/core/NoisExpression.hpp"
+
+#include "nois/NoisUtil.hpp"
+#include "nois/util/NoisMappings.hpp"
+#include "nois/memory/NoisAllocator.hpp"
+
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <numbers>
+#include <string_view>
+
+namespace nois {
+
+namespace {
+
+// Frames run per pass over the program, small enough for every register to stay in L1
+constexpr count_t k_ChunkFrames = 64;
+constexpr count_t k_MaxRegisters = 64;
+
+constexpr f32_t k_Log2E = 1.44269504088896f;
+constexpr f32_t k_Log2Ten20 = 0.166096404744368f;
+
+enum class Op : uint8_t
+{
+	Input,
+	SampleRate,
+	Add,
+	Sub,
+	Mul,
+	Div,
+	Pow,
+	Neg,
+	Min,
+	Max,
+	Clamp,
+	Abs,
+	Sqrt,
+	Exp,
+	Log,
+	Sin,
+	Cos,
+	Tanh,
+	Db,
+	ToDb,
+	Lfo,
+	Saw
+};
+
+struct Instruction
+{
+	Op op = Op::Input;
+	count_t dst = 0;
+	count_t a = 0;
+	count_t b = 0;
+	count_t c = 0;
+	// Input index or oscillator phase
+	count_t index = 0;
+};
+
+struct Function
+{
+	std::string_view name;
+	Op op;
+	count_t numArgs;
+};
+
+constexpr std::array<Function, 15> k_Functions = { {
+	{ "db", Op::Db, 1 },
+	{ "todb", Op::ToDb, 1 },
+	{ "exp", Op::Exp, 1 },
+	{ "log", Op::Log, 1 },
+	{ "sqrt", Op::Sqrt, 1 },
+	{ "abs", Op::Abs, 1 },
+	{ "sin", Op::Sin, 1 },
+	{ "cos", Op::Cos, 1 },
+	{ "tanh", Op::Tanh, 1 },
+	{ "min", Op::Min, 2 },
+	{ "max", Op::Max, 2 },
+	{ "pow", Op::Pow, 2 },
+	{ "clamp", Op::Clamp, 3 },
+	{ "lfo", Op::Lfo, 1 },
+	{ "saw", Op::Saw, 1 },
+} };
+
+// Scalar semantics of every pure op, shared by constant folding and uniform registers
+f32_t Evaluate(Op op, f32_t a, f32_t b, f32_t c)
+{
+	switch (op)
+	{
+	case Op::Add: return a + b;
+	case Op::Sub: return a - b;
+	case Op::Mul: return a * b;
+	case Op::Div: return a / b;
+	case Op::Pow: return std::pow(a, b);
+	case Op::Neg: return -a;
+	case Op::Min: return std::min(a, b);
+	case Op::Max: return std::max(a, b);
+	// Same order as the block loop, std::clamp is undefined for an inverted range
+	case Op::Clamp: return std::min(std::max(a, b), c);
+	case Op::Abs: return std::abs(a);
+	case Op::Sqrt: return std::sqrt(a);
+	case Op::Exp: return mapping::detail::Exp2(a * k_Log2E);
+	case Op::Log: return std::log(a);
+	case Op::Sin: return std::sin(a);
+	case Op::Cos: return std::cos(a);
+	case Op::Tanh: return std::tanh(a);
+	case Op::Db: return mapping::detail::Exp2(a * k_Log2Ten20);
+	case Op::ToDb: return ToDb(a);
+	default: return 0.0f;
+	}
+}
+
+bool IsPure(Op op)
+{
+	return op != Op::Input && op != Op::SampleRate && op != Op::Lfo && op != Op::Saw;
+}
+
+}
+
+class Expression::Impl
+{
+public:
+	bool Compile(const std::string& source, std::string* error)
+	{
+		m_Source = source;
+		m_Position = 0;
+		m_Error.clear();
+		m_InputRegisters.fill(-1);
+
+		// Register 0 is a zero that unused operands point at
+		Constant(0.0f);
+
+		count_t result = ParseSum();
+		SkipSpaces();
+
+		if (m_Error.empty() && m_Position < m_Source.size())
+		{
+			Fail("unexpected '" + std::string(1, m_Source[m_Position]) + "'");
+		}
+
+		if (!m_Error.empty())
+		{
+			if (error)
+			{
+				*error = m_Error;
+			}
+
+			return false;
+		}
+
+		m_Result = result;
+		m_Registers.assign(m_NumRegisters * k_ChunkFrames, 0.0f);
+		m_IsUniform.assign(m_NumRegisters, false);
+		m_IsExpanded.assign(m_NumRegisters, false);
+		m_Phases.assign(m_NumPhases, 0.0);
+
+		// Constants are uniform and expanded for good
+		for (const auto& [reg, value] : m_Constants)
+		{
+			std::fill_n(Register(reg), k_ChunkFrames, value);
+		}
+
+		return true;
+	}
+
+	count_t GetNumInputs() const
+	{
+		return m_NumInputs;
+	}
+
+	bool IsTimeVarying() const
+	{
+		return m_NumPhases > 0;
+	}
+
+	void Process(f32_t* out, count_t numFrames, const BlockSpan<f32_t>* inputs, f32_t sampleRate)
+	{
+		NOIS_PROFILE_SCOPE();
+
+		bool isConstant = !IsTimeVarying();
+
+		for (count_t i = 0; i < m_NumInputs; ++i)
+		{
+			isConstant = isConstant && inputs[i].IsConstant();
+		}
+
+		// Nothing moves within the block, one frame is enough
+		count_t numRendered = isConstant ? std::min<count_t>(numFrames, 1) : numFrames;
+
+		for (count_t begin = 0; begin < numRendered; begin += k_ChunkFrames)
+		{
+			count_t n = std::min(k_ChunkFrames, numRendered - begin);
+
+			RunChunk(begin, n, inputs, sampleRate);
+
+			if (m_IsUniform[m_Result])
+			{
+				std::fill_n(out + begin, n, Register(m_Result)[0]);
+			}
+			else
+			{
+				std::copy_n(Register(m_Result), n, out + begin);
+			}
+		}
+
+		if (numRendered < numFrames)
+		{
+			std::fill(out + numRendered, out + numFrames, out[0]);
+		}
+	}
+
+private:
+	// Parsing, each rule emits code and returns the register holding its value
+
+	count_t ParseSum()
+	{
+		count_t lhs = ParseProduct();
+
+		for (;;)
+		{
+			if (Accept('+'))
+			{
+				lhs = Emit(Op::Add, lhs, ParseProduct());
+			}
+			else if (Accept('-'))
+			{
+				lhs = Emit(Op::Sub, lhs, ParseProduct());
+			}
+			else
+			{
+				return lhs;
+			}
+		}
+	}
+
+	count_t ParseProduct()
+	{
+		count_t lhs = ParseUnary();
+
+		for (;;)
+		{
+			if (Accept('*'))
+			{
+				lhs = Emit(Op::Mul, lhs, ParseUnary());
+			}
+			else if (Accept('/'))
+			{
+				lhs = Emit(Op::Div, lhs, ParseUnary());
+			}
+			else
+			{
+				return lhs;
+			}
+		}
+	}
+
+	count_t ParseUnary()
+	{
+		if (Accept('-'))
+		{
+			return Emit(Op::Neg, ParseUnary());
+		}
+
+		count_t base = ParsePrimary();
+
+		// Right associative and binding tighter than unary minus on its left
+		if (Accept('^'))
+		{
+			return Emit(Op::Pow, base, ParseUnary());
+		}
+
+		return base;
+	}
+
+	count_t ParsePrimary()
+	{
+		SkipSpaces();
+
+		if (!m_Error.empty() || m_Position >= m_Source.size())
+		{
+			return Fail("expected a value");
+		}
+
+		char next = m_Source[m_Position];
+
+		if (Accept('('))
+		{
+			count_t inner = ParseSum();
+			Expect(')');
+			return inner;
+		}
+
+		if (std::isdigit(static_cast<unsigned char>(next)) || next == '.')
+		{
+			return ParseNumber();
+		}
+
+		if (std::isalpha(static_cast<unsigned char>(next)))
+		{
+			return ParseName();
+		}
+
+		return Fail("unexpected '" + std::string(1, next) + "'");
+	}
+
+	count_t ParseNumber()
+	{
+		size_t begin = m_Position;
+		count_t numPoints = 0;
+
+		while (m_Position < m_Source.size() &&
+			(std::isdigit(static_cast<unsigned char>(m_Source[m_Position])) || m_Source[m_Position] == '.'))
+		{
+			numPoints += m_Source[m_Position] == '.';
+			++m_Position;
+		}
+
+		f32_t value = 0.0f;
+		size_t numParsed = 0;
+		std::string text = m_Source.substr(begin, m_Position - begin);
+
+		try
+		{
+			value = std::stof(text, &numParsed);
+		}
+		catch (...)
+		{
+			return Fail("malformed number");
+		}
+
+		// stof stops at a second point, "1.2.3" would read as 1.2
+		if (numPoints > 1 || numParsed != text.size())
+		{
+			return Fail("malformed number");
+		}
+
+		std::string unit = ReadWord();
+
+		if (unit == "hz" || unit == "s" || unit.empty())
+		{
+		}
+		else if (unit == "khz")
+		{
+			value *= 1000.0f;
+		}
+		else if (unit == "ms")
+		{
+			value *= 0.001f;
+		}
+		else if (unit == "db")
+		{
+			value = FromDb(value);
+		}
+		else
+		{
+			return Fail("unknown unit '" + unit + "'");
+		}
+
+		return Constant(value);
+	}
+
+	count_t ParseName()
+	{
+		size_t begin = m_Position;
+		std::string name = ReadWord();
+
+		SkipSpaces();
+
+		if (m_Position < m_Source.size() && m_Source[m_Position] == '(')
+		{
+			return ParseCall(name, begin);
+		}
+
+		if (name.size() == 1 && name[0] >= 'w' && name[0] <= 'z')
+		{
+			// x, y, z, w
+			count_t index = name[0] == 'w' ? 3 : name[0] - 'x';
+			return Input(index);
+		}
+
+		if (name == "pi")
+		{
+			return Constant(std::numbers::pi_v<f32_t>);
+		}
+
+		if (name == "sr")
+		{
+			return Emit(Op::SampleRate);
+		}
+
+		m_Position = begin;
+		return Fail("unknown name '" + name + "'");
+	}
+
+	count_t ParseCall(const std::string& name, size_t begin)
+	{
+		const Function* function = nullptr;
+
+		for (const auto& candidate : k_Functions)
+		{
+			if (candidate.name == name)
+			{
+				function = &candidate;
+			}
+		}
+
+		if (!function)
+		{
+			m_Position = begin;
+			return Fail("unknown function '" + name + "'");
+		}
+
+		std::array<count_t, 3> args = { 0, 0, 0 };
+		count_t numArgs = 0;
+
+		Expect('(');
+
+		if (!Accept(')'))
+		{
+			do
+			{
+				count_t arg = ParseSum();
+
+				if (numArgs < static_cast<count_t>(args.size()))
+				{
+					args[numArgs] = arg;
+				}
+
+				++numArgs;
+			}
+			while (Accept(','));
+
+			Expect(')');
+		}
+
+		if (m_Error.empty() && numArgs != function->numArgs)
+		{
+			m_Position = begin;
+			return Fail(name + " takes " + std::to_string(function->numArgs) + " argument" + (function->numArgs == 1 ? "" : "s"));
+		}
+
+		return Emit(function->op, args[0], args[1], args[2]);
+	}
+
+	// Code generation
+
+	count_t Input(count_t index)
+	{
+		if (m_InputRegisters[index] < 0)
+		{
+			m_InputRegisters[index] = Emit(Op::Input, 0, 0, 0, index);
+			m_NumInputs = std::max(m_NumInputs, index + 1);
+		}
+
+		return m_InputRegisters[index];
+	}
+
+	count_t Constant(f32_t value)
+	{
+		count_t reg = Allocate();
+		m_Constants.push_back({ reg, value });
+		return reg;
+	}
+
+	count_t Emit(Op op, count_t a = 0, count_t b = 0, count_t c = 0, count_t index = 0)
+	{
+		if (!m_Error.empty())
+		{
+			return 0;
+		}
+
+		// Folds pure ops over constants at compile time
+		if (IsPure(op) && IsConstant(a) && IsConstant(b) && IsConstant(c))
+		{
+			return Constant(Evaluate(op, ConstantValue(a), ConstantValue(b), ConstantValue(c)));
+		}
+
+		if (op == Op::Lfo || op == Op::Saw)
+		{
+			index = m_NumPhases++;
+		}
+
+		count_t dst = Allocate();
+		m_Program.push_back({ op, dst, a, b, c, index });
+		return dst;
+	}
+
+	count_t Allocate()
+	{
+		if (m_NumRegisters >= k_MaxRegisters)
+		{
+			return Fail("expression is too long");
+		}
+
+		return m_NumRegisters++;
+	}
+
+	bool IsConstant(count_t reg) const
+	{
+		for (const auto& constant : m_Constants)
+		{
+			if (constant.first == reg)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	f32_t ConstantValue(count_t reg) const
+	{
+		for (const auto& constant : m_Constants)
+		{
+			if (constant.first == reg)
+			{
+				return constant.second;
+			}
+		}
+
+		return 0.0f;
+	}
+
+	// Lexing
+
+	void SkipSpaces()
+	{
+		while (m_Position < m_Source.size() && std::isspace(static_cast<unsigned char>(m_Source[m_Position])))
+		{
+			++m_Position;
+		}
+	}
+
+	bool Accept(char c)
+	{
+		SkipSpaces();
+
+		if (m_Error.empty() && m_Position < m_Source.size() && m_Source[m_Position] == c)
+		{
+			++m_Position;
+			return true;
+		}
+
+		return false;
+	}
+
+	void Expect(char c)
+	{
+		if (!Accept(c))
+		{
+			Fail(std::string("expected '") + c + "'");
+		}
+	}
+
+	std::string ReadWord()
+	{
+		size_t begin = m_Position;
+
+		while (m_Position < m_Source.size() && std::isalpha(static_cast<unsigned char>(m_Source[m_Position])))
+		{
+			++m_Position;
+		}
+
+		return m_Source.substr(begin, m_Position - begin);
+	}
+
+	count_t Fail(const std::string& message)
+	{
+		if (m_Error.empty())
+		{
+			m_Error = message + " at column " + std::to_string(m_Position + 1);
+		}
+
+		return 0;
+	}
+
+	// Execution
+
+	f32_t* Register(count_t reg)
+	{
+		return m_Registers.data() + reg * k_ChunkFrames;
+	}
+
+	// Broadcasts a uniform register before a per-frame op reads it
+	const f32_t* Expand(count_t reg)
+	{
+		f32_t* values = Register(reg);
+
+		if (m_IsUniform[reg] && !m_IsExpanded[reg])
+		{
+			std::fill_n(values + 1, k_ChunkFrames - 1, values[0]);
+			m_IsExpanded[reg] = true;
+		}
+
+		return values;
+	}
+
+	void SetUniform(count_t reg, f32_t value)
+	{
+		Register(reg)[0] = value;
+		m_IsUniform[reg] = true;
+		m_IsExpanded[reg] = false;
+	}
+
+	void RunChunk(count_t begin, count_t n, const BlockSpan<f32_t>* inputs, f32_t sampleRate)
+	{
+		for (const auto& [reg, value] : m_Constants)
+		{
+			m_IsUniform[reg] = true;
+			m_IsExpanded[reg] = true;
+		}
+
+		for (const Instruction& instruction : m_Program)
+		{
+			count_t dst = instruction.dst;
+			f32_t* out = Register(dst);
+
+			switch (instruction.op)
+			{
+			case Op::Input:
+			{
+				const BlockSpan<f32_t>& span = inputs[instruction.index];
+
+				if (span.IsConstant())
+				{
+					SetUniform(dst, span.values[0]);
+				}
+				else
+				{
+					for (count_t i = 0; i < n; ++i)
+					{
+						out[i] = span[begin + i];
+					}
+
+					m_IsUniform[dst] = false;
+				}
+				break;
+			}
+			case Op::SampleRate:
+			{
+				SetUniform(dst, sampleRate);
+				break;
+			}
+			case Op::Lfo:
+			case Op::Saw:
+			{
+				RunOscillator(instruction, n, sampleRate);
+				break;
+			}
+			default:
+			{
+				RunPure(instruction, n);
+				break;
+			}
+			}
+		}
+	}
+
+	void RunPure(const Instruction& instruction, count_t n)
+	{
+		count_t dst = instruction.dst;
+		Op op = instruction.op;
+
+		if (m_IsUniform[instruction.a] && m_IsUniform[instruction.b] && m_IsUniform[instruction.c])
+		{
+			SetUniform(dst, Evaluate(op, Register(instruction.a)[0], Register(instruction.b)[0], Register(instruction.c)[0]));
+			return;
+		}
+
+		const f32_t* a = Expand(instruction.a);
+		const f32_t* b = Expand(instruction.b);
+		const f32_t* c = Expand(instruction.c);
+		f32_t* out = Register(dst);
+
+		m_IsUniform[dst] = false;
+
+		// Plain loops over whole chunks, the arithmetic ones vectorize as they are
+		switch (op)
+		{
+		case Op::Add: for (count_t i = 0; i < n; ++i) out[i] = a[i] + b[i]; break;
+		case Op::Sub: for (count_t i = 0; i < n; ++i) out[i] = a[i] - b[i]; break;
+		case Op::Mul: for (count_t i = 0; i < n; ++i) out[i] = a[i] * b[i]; break;
+		case Op::Div: for (count_t i = 0; i < n; ++i) out[i] = a[i] / b[i]; break;
+		case Op::Neg: for (count_t i = 0; i < n; ++i) out[i] = -a[i]; break;
+		case Op::Min: for (count_t i = 0; i < n; ++i) out[i] = std::min(a[i], b[i]); break;
+		case Op::Max: for (count_t i = 0; i < n; ++i) out[i] = std::max(a[i], b[i]); break;
+		case Op::Clamp: for (count_t i = 0; i < n; ++i) out[i] = std::min(std::max(a[i], b[i]), c[i]); break;
+		case Op::Abs: for (count_t i = 0; i < n; ++i) out[i] = std::abs(a[i]); break;
+		case Op::Exp: RunExp2(out, a, n, k_Log2E); break;
+		case Op::Db: RunExp2(out, a, n, k_Log2Ten20); break;
+		default: for (count_t i = 0; i < n; ++i) out[i] = Evaluate(op, a[i], b[i], c[i]); break;
+		}
+	}
+
+	// 2^(x * scale) four frames at a time
+	void RunExp2(f32_t* out, const f32_t* a, count_t n, f32_t scale)
+	{
+		count_t i = 0;
+
+#if NOIS_ARCH_X64
+		__m128 k = _mm_set1_ps(scale);
+
+		for (; i + 4 <= n; i += 4)
+		{
+			_mm_storeu_ps(out + i, mapping::detail::Exp2(_mm_mul_ps(_mm_loadu_ps(a + i), k)));
+		}
+#endif // NOIS_ARCH_X64
+
+		for (; i < n; ++i)
+		{
+			out[i] = mapping::detail::Exp2(a[i] * scale);
+		}
+	}
+
+	void RunOscillator(const Instruction& instruction, count_t n, f32_t sampleRate)
+	{
+		const f32_t* frequency = Expand(instruction.a);
+		f32_t* out = Register(instruction.dst);
+		f64_t phase = m_Phases[instruction.index];
+		f64_t toIncrement = sampleRate > 0.0f ? 1.0 / sampleRate : 0.0;
+
+		for (count_t i = 0; i < n; ++i)
+		{
+			out[i] = static_cast<f32_t>(phase);
+			phase += frequency[i] * toIncrement;
+			phase -= std::floor(phase);
+		}
+
+		if (instruction.op == Op::Lfo)
+		{
+			for (count_t i = 0; i < n; ++i)
+			{
+				out[i] = std::sin(2.0f * std::numbers::pi_v<f32_t> * out[i]);
+			}
+		}
+		else
+		{
+			for (count_t i = 0; i < n; ++i)
+			{
+				out[i] = 2.0f * out[i] - 1.0f;
+			}
+		}
+
+		m_Phases[instruction.index] = phase;
+		m_IsUniform[instruction.dst] = false;
+	}
+
+private:
+	// Compiling
+	std::string m_Source;
+	size_t m_Position = 0;
+	std::string m_Error;
+	std::array<count_t, k_MaxInputs> m_InputRegisters = {};
+
+	// Program
+	std::vector<Instruction> m_Program;
+	std::vector<std::pair<count_t, f32_t>> m_Constants;
+	count_t m_NumRegisters = 0;
+	count_t m_NumInputs = 0;
+	count_t m_NumPhases = 0;
+	count_t m_Result = 0;
+
+	// Running, one chunk per register
+	std::vector<f32_t, AlignedAllocator<f32_t, k_SimdAlignment>> m_Registers;
+	std::vector<bool> m_IsUniform;
+	std::vector<bool> m_IsExpanded;
+	std::vector<f64_t> m_Phases;
+};
+
+Expression::Expression(Own_t<Impl> impl)
+	: m_Impl(std::move(impl))
+{
+}
+
+Expression::~Expression()
+{
+}
+
+Ref_t<Expression> Expression::Compile(const std::string& source, std::string* error)
+{
+	auto impl = MakeOwn<Impl>();
+
+	if (!impl->Compile(source, error))
+	{
+		return nullptr;
+	}
+
+	return MakeRef<Expression>(std::move(impl));
+}
+
+count_t Expression::GetNumInputs() const
+{
+	return m_Impl->GetNumInputs();
+}
+
+bool Expression::IsTimeVarying() const
+{
+	return m_Impl->IsTimeVarying();
+}
+
+void Expression::Process(f32_t* out, count_t numFrames, const BlockSpan<f32_t>* inputs, f32_t sampleRate)
+{
+	m_Impl->Process(out, numFrames, inputs, sampleRate);
+}
+
+}
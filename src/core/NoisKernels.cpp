@@ -0,0 +1,383 @@
+#include "nois/core/NoisKernels.hpp"
+
+#if NOIS_ARCH_X64
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif // _MSC_VER
+#elif NOIS_ARCH_ARM64
+#include <arm_neon.h>
+#endif // NOIS_ARCH_X64
+
+// GCC and Clang compile a function for an instruction set when asked per function,
+// MSVC emits whatever intrinsics it's given
+#if defined(__GNUC__) && !defined(_MSC_VER)
+#define NOIS_TARGET_ATTRIBUTE(_isa) __attribute__((target(_isa)))
+#else
+#define NOIS_TARGET_ATTRIBUTE(_isa)
+#endif
+
+namespace nois::kernel {
+
+namespace {
+
+namespace scalar {
+
+inline void Deinterleave2(f32_t a, f32_t b, f32_t& left, f32_t& right)
+{
+	left = a;
+	right = b;
+}
+
+inline void Interleave2(f32_t left, f32_t right, f32_t& a, f32_t& b)
+{
+	a = left;
+	b = right;
+}
+
+#define NOIS_KERNEL_ISA Isa::Scalar
+#define NOIS_KERNEL_TARGET
+#define NOIS_VEC f32_t
+#define NOIS_WIDTH 1
+#define NOIS_LOAD(_p) (*(_p))
+#define NOIS_STORE(_p, _v) (*(_p) = (_v))
+#define NOIS_SET1(_x) (_x)
+#define NOIS_ADD(_a, _b) ((_a) + (_b))
+#define NOIS_SUB(_a, _b) ((_a) - (_b))
+#define NOIS_MUL(_a, _b) ((_a) * (_b))
+#define NOIS_MULADD(_a, _b, _c) ((_a) * (_b) + (_c))
+#include "NoisKernels.inl"
+#undef NOIS_KERNEL_ISA
+#undef NOIS_KERNEL_TARGET
+#undef NOIS_VEC
+#undef NOIS_WIDTH
+#undef NOIS_LOAD
+#undef NOIS_STORE
+#undef NOIS_SET1
+#undef NOIS_ADD
+#undef NOIS_SUB
+#undef NOIS_MUL
+#undef NOIS_MULADD
+
+}
+
+#if NOIS_ARCH_X64
+
+namespace sse2 {
+
+inline void Deinterleave2(__m128 a, __m128 b, __m128& left, __m128& right)
+{
+	left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+	right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+inline void Interleave2(__m128 left, __m128 right, __m128& a, __m128& b)
+{
+	a = _mm_unpacklo_ps(left, right);
+	b = _mm_unpackhi_ps(left, right);
+}
+
+#define NOIS_KERNEL_ISA Isa::Sse2
+#define NOIS_KERNEL_TARGET
+#define NOIS_VEC __m128
+#define NOIS_WIDTH 4
+#define NOIS_LOAD(_p) _mm_loadu_ps(_p)
+#define NOIS_STORE(_p, _v) _mm_storeu_ps(_p, _v)
+#define NOIS_SET1(_x) _mm_set1_ps(_x)
+#define NOIS_ADD(_a, _b) _mm_add_ps(_a, _b)
+#define NOIS_SUB(_a, _b) _mm_sub_ps(_a, _b)
+#define NOIS_MUL(_a, _b) _mm_mul_ps(_a, _b)
+#define NOIS_MULADD(_a, _b, _c) _mm_add_ps(_mm_mul_ps(_a, _b), _c)
+#include "NoisKernels.inl"
+#undef NOIS_KERNEL_ISA
+#undef NOIS_KERNEL_TARGET
+#undef NOIS_VEC
+#undef NOIS_WIDTH
+#undef NOIS_LOAD
+#undef NOIS_STORE
+#undef NOIS_SET1
+#undef NOIS_ADD
+#undef NOIS_SUB
+#undef NOIS_MUL
+#undef NOIS_MULADD
+
+}
+
+namespace avx2 {
+
+// Shuffles work within 128-bit lanes, the permutes put the halves back in order
+NOIS_TARGET_ATTRIBUTE("avx2,fma") inline void Deinterleave2(__m256 a, __m256 b, __m256& left, __m256& right)
+{
+	__m256 even = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+	__m256 odd = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+	left = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(even), _MM_SHUFFLE(3, 1, 2, 0)));
+	right = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(odd), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+NOIS_TARGET_ATTRIBUTE("avx2,fma") inline void Interleave2(__m256 left, __m256 right, __m256& a, __m256& b)
+{
+	__m256 low = _mm256_unpacklo_ps(left, right);
+	__m256 high = _mm256_unpackhi_ps(left, right);
+	a = _mm256_permute2f128_ps(low, high, 0x20);
+	b = _mm256_permute2f128_ps(low, high, 0x31);
+}
+
+#define NOIS_KERNEL_ISA Isa::Avx2
+#define NOIS_KERNEL_TARGET NOIS_TARGET_ATTRIBUTE("avx2,fma")
+#define NOIS_VEC __m256
+#define NOIS_WIDTH 8
+#define NOIS_LOAD(_p) _mm256_loadu_ps(_p)
+#define NOIS_STORE(_p, _v) _mm256_storeu_ps(_p, _v)
+#define NOIS_SET1(_x) _mm256_set1_ps(_x)
+#define NOIS_ADD(_a, _b) _mm256_add_ps(_a, _b)
+#define NOIS_SUB(_a, _b) _mm256_sub_ps(_a, _b)
+#define NOIS_MUL(_a, _b) _mm256_mul_ps(_a, _b)
+#define NOIS_MULADD(_a, _b, _c) _mm256_fmadd_ps(_a, _b, _c)
+#include "NoisKernels.inl"
+#undef NOIS_KERNEL_ISA
+#undef NOIS_KERNEL_TARGET
+#undef NOIS_VEC
+#undef NOIS_WIDTH
+#undef NOIS_LOAD
+#undef NOIS_STORE
+#undef NOIS_SET1
+#undef NOIS_ADD
+#undef NOIS_SUB
+#undef NOIS_MUL
+#undef NOIS_MULADD
+
+}
+
+namespace avx512 {
+
+NOIS_TARGET_ATTRIBUTE("avx512f") inline void Deinterleave2(__m512 a, __m512 b, __m512& left, __m512& right)
+{
+	__m512i even = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16, 14, 12, 10, 8, 6, 4, 2, 0);
+	__m512i odd = _mm512_set_epi32(31, 29, 27, 25, 23, 21, 19, 17, 15, 13, 11, 9, 7, 5, 3, 1);
+	left = _mm512_permutex2var_ps(a, even, b);
+	right = _mm512_permutex2var_ps(a, odd, b);
+}
+
+NOIS_TARGET_ATTRIBUTE("avx512f") inline void Interleave2(__m512 left, __m512 right, __m512& a, __m512& b)
+{
+	__m512i low = _mm512_set_epi32(23, 7, 22, 6, 21, 5, 20, 4, 19, 3, 18, 2, 17, 1, 16, 0);
+	__m512i high = _mm512_set_epi32(31, 15, 30, 14, 29, 13, 28, 12, 27, 11, 26, 10, 25, 9, 24, 8);
+	a = _mm512_permutex2var_ps(left, low, right);
+	b = _mm512_permutex2var_ps(left, high, right);
+}
+
+#define NOIS_KERNEL_ISA Isa::Avx512
+#define NOIS_KERNEL_TARGET NOIS_TARGET_ATTRIBUTE("avx512f")
+#define NOIS_VEC __m512
+#define NOIS_WIDTH 16
+#define NOIS_LOAD(_p) _mm512_loadu_ps(_p)
+#define NOIS_STORE(_p, _v) _mm512_storeu_ps(_p, _v)
+#define NOIS_SET1(_x) _mm512_set1_ps(_x)
+#define NOIS_ADD(_a, _b) _mm512_add_ps(_a, _b)
+#define NOIS_SUB(_a, _b) _mm512_sub_ps(_a, _b)
+#define NOIS_MUL(_a, _b) _mm512_mul_ps(_a, _b)
+#define NOIS_MULADD(_a, _b, _c) _mm512_fmadd_ps(_a, _b, _c)
+#include "NoisKernels.inl"
+#undef NOIS_KERNEL_ISA
+#undef NOIS_KERNEL_TARGET
+#undef NOIS_VEC
+#undef NOIS_WIDTH
+#undef NOIS_LOAD
+#undef NOIS_STORE
+#undef NOIS_SET1
+#undef NOIS_ADD
+#undef NOIS_SUB
+#undef NOIS_MUL
+#undef NOIS_MULADD
+
+}
+
+#elif NOIS_ARCH_ARM64
+
+namespace neon {
+
+inline void Deinterleave2(float32x4_t a, float32x4_t b, float32x4_t& left, float32x4_t& right)
+{
+	left = vuzp1q_f32(a, b);
+	right = vuzp2q_f32(a, b);
+}
+
+inline void Interleave2(float32x4_t left, float32x4_t right, float32x4_t& a, float32x4_t& b)
+{
+	a = vzip1q_f32(left, right);
+	b = vzip2q_f32(left, right);
+}
+
+#define NOIS_KERNEL_ISA Isa::Neon
+#define NOIS_KERNEL_TARGET
+#define NOIS_VEC float32x4_t
+#define NOIS_WIDTH 4
+#define NOIS_LOAD(_p) vld1q_f32(_p)
+#define NOIS_STORE(_p, _v) vst1q_f32(_p, _v)
+#define NOIS_SET1(_x) vdupq_n_f32(_x)
+#define NOIS_ADD(_a, _b) vaddq_f32(_a, _b)
+#define NOIS_SUB(_a, _b) vsubq_f32(_a, _b)
+#define NOIS_MUL(_a, _b) vmulq_f32(_a, _b)
+#define NOIS_MULADD(_a, _b, _c) vfmaq_f32(_c, _a, _b)
+#include "NoisKernels.inl"
+#undef NOIS_KERNEL_ISA
+#undef NOIS_KERNEL_TARGET
+#undef NOIS_VEC
+#undef NOIS_WIDTH
+#undef NOIS_LOAD
+#undef NOIS_STORE
+#undef NOIS_SET1
+#undef NOIS_ADD
+#undef NOIS_SUB
+#undef NOIS_MUL
+#undef NOIS_MULADD
+
+}
+
+#endif // NOIS_ARCH_X64
+
+// Only the tables built for this architecture exist
+const Table* FindTable(Isa isa)
+{
+	switch (isa)
+	{
+	case Isa::Scalar: return &scalar::k_Table;
+#if NOIS_ARCH_X64
+	case Isa::Sse2: return &sse2::k_Table;
+	case Isa::Avx2: return &avx2::k_Table;
+	case Isa::Avx512: return &avx512::k_Table;
+#elif NOIS_ARCH_ARM64
+	case Isa::Neon: return &neon::k_Table;
+#endif // NOIS_ARCH_X64
+	default: return nullptr;
+	}
+}
+
+Isa Detect()
+{
+#if NOIS_ARCH_X64
+#if defined(_MSC_VER)
+	int info[4] = {};
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool hasOsXsave = (info[2] & (1 << 27)) != 0;
+	bool hasFma = (info[2] & (1 << 12)) != 0;
+
+	if (!hasOsXsave || maxLeaf < 7)
+	{
+		return Isa::Sse2;
+	}
+
+	u64_t xcr0 = _xgetbv(0);
+
+	__cpuidex(info, 7, 0);
+	bool hasAvx2 = (info[1] & (1 << 5)) != 0;
+	bool hasAvx512 = (info[1] & (1 << 16)) != 0;
+#else
+	unsigned int eax = 0;
+	unsigned int ebx = 0;
+	unsigned int ecx = 0;
+	unsigned int edx = 0;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || (ecx & (1u << 27)) == 0)
+	{
+		return Isa::Sse2;
+	}
+
+	// Read through asm, the intrinsic needs the function compiled for XSAVE
+	u32_t xcr0Low = 0;
+	u32_t xcr0High = 0;
+	__asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+	u64_t xcr0 = (static_cast<u64_t>(xcr0High) << 32) | xcr0Low;
+
+	// Can run before constructors, so initialize explicitly
+	__builtin_cpu_init();
+
+	bool hasFma = __builtin_cpu_supports("fma");
+	bool hasAvx2 = __builtin_cpu_supports("avx2");
+	bool hasAvx512 = __builtin_cpu_supports("avx512f");
+#endif // _MSC_VER
+
+	// The OS has to save the wide registers on context switches too
+	bool hasYmm = (xcr0 & 0x6) == 0x6;
+	bool hasZmm = (xcr0 & 0xe6) == 0xe6;
+
+	if (hasAvx512 && hasFma && hasAvx2 && hasZmm)
+	{
+		return Isa::Avx512;
+	}
+
+	if (hasAvx2 && hasFma && hasYmm)
+	{
+		return Isa::Avx2;
+	}
+
+	return Isa::Sse2;
+#elif NOIS_ARCH_ARM64
+	// Every ARM64 core has NEON
+	return Isa::Neon;
+#else
+	return Isa::Scalar;
+#endif // NOIS_ARCH_X64
+}
+
+// Picks the widest kernels during static initialization
+struct Selector
+{
+	Selector()
+	{
+		Select(GetBestIsa());
+	}
+};
+
+}
+
+namespace detail {
+
+std::atomic<const Table*> g_Table{ &scalar::k_Table };
+
+}
+
+namespace {
+
+Selector s_Selector;
+
+}
+
+Isa GetBestIsa()
+{
+	static const Isa k_BestIsa = Detect();
+	return k_BestIsa;
+}
+
+bool Select(Isa isa)
+{
+	const Table* table = FindTable(isa);
+
+	if (!table || (isa != Isa::Scalar && isa > GetBestIsa()))
+	{
+		return false;
+	}
+
+	detail::g_Table.store(table, std::memory_order_relaxed);
+	return true;
+}
+
+const char* GetName(Isa isa)
+{
+	switch (isa)
+	{
+	case Isa::Scalar: return "Scalar";
+	case Isa::Sse2: return "SSE2";
+	case Isa::Avx2: return "AVX2";
+	case Isa::Avx512: return "AVX-512";
+	case Isa::Neon: return "NEON";
+	default: return "Unknown";
+	}
+}
+
+}
@@ -0,0 +1,206 @@
+// Kernel bodies, included once per instruction set by NoisKernels.cpp
+// The includer defines NOIS_KERNEL_ISA, NOIS_KERNEL_TARGET, the vector type NOIS_VEC holding
+// NOIS_WIDTH floats and NOIS_LOAD, NOIS_STORE, NOIS_SET1, NOIS_ADD, NOIS_SUB, NOIS_MUL and
+// NOIS_MULADD(a, b, c) as a * b + c. Tails shorter than a vector run one frame at a time.
+// It also provides Deinterleave2(a, b, left, right) and Interleave2(left, right, a, b),
+// which split two vectors of stereo frames into a vector per channel and back.
+
+NOIS_KERNEL_TARGET void Add(f32_t* out, const f32_t* in, count_t size)
+{
+	count_t i = 0;
+
+	for (; i + NOIS_WIDTH <= size; i += NOIS_WIDTH)
+	{
+		NOIS_STORE(out + i, NOIS_ADD(NOIS_LOAD(out + i), NOIS_LOAD(in + i)));
+	}
+
+	for (; i < size; ++i)
+	{
+		out[i] += in[i];
+	}
+}
+
+NOIS_KERNEL_TARGET void Sum(f32_t* out, const f32_t* in1, const f32_t* in2, count_t size)
+{
+	count_t i = 0;
+
+	for (; i + NOIS_WIDTH <= size; i += NOIS_WIDTH)
+	{
+		NOIS_STORE(out + i, NOIS_ADD(NOIS_LOAD(in1 + i), NOIS_LOAD(in2 + i)));
+	}
+
+	for (; i < size; ++i)
+	{
+		out[i] = in1[i] + in2[i];
+	}
+}
+
+NOIS_KERNEL_TARGET void Subtract(f32_t* out, const f32_t* in, count_t size)
+{
+	count_t i = 0;
+
+	for (; i + NOIS_WIDTH <= size; i += NOIS_WIDTH)
+	{
+		NOIS_STORE(out + i, NOIS_SUB(NOIS_LOAD(out + i), NOIS_LOAD(in + i)));
+	}
+
+	for (; i < size; ++i)
+	{
+		out[i] -= in[i];
+	}
+}
+
+NOIS_KERNEL_TARGET void Multiply(f32_t* out, const f32_t* in, count_t size)
+{
+	count_t i = 0;
+
+	for (; i + NOIS_WIDTH <= size; i += NOIS_WIDTH)
+	{
+		NOIS_STORE(out + i, NOIS_MUL(NOIS_LOAD(out + i), NOIS_LOAD(in + i)));
+	}
+
+	for (; i < size; ++i)
+	{
+		out[i] *= in[i];
+	}
+}
+
+NOIS_KERNEL_TARGET void AddScaled(f32_t* out, const f32_t* in, f32_t factor, count_t size)
+{
+	NOIS_VEC k = NOIS_SET1(factor);
+	count_t i = 0;
+
+	for (; i + NOIS_WIDTH <= size; i += NOIS_WIDTH)
+	{
+		NOIS_STORE(out + i, NOIS_MULADD(NOIS_LOAD(in + i), k, NOIS_LOAD(out + i)));
+	}
+
+	for (; i < size; ++i)
+	{
+		out[i] += in[i] * factor;
+	}
+}
+
+NOIS_KERNEL_TARGET void Scale(f32_t* out, const f32_t* in, f32_t factor, count_t size)
+{
+	NOIS_VEC k = NOIS_SET1(factor);
+	count_t i = 0;
+
+	for (; i + NOIS_WIDTH <= size; i += NOIS_WIDTH)
+	{
+		NOIS_STORE(out + i, NOIS_MUL(NOIS_LOAD(in + i), k));
+	}
+
+	for (; i < size; ++i)
+	{
+		out[i] = in[i] * factor;
+	}
+}
+
+NOIS_KERNEL_TARGET void Mix(f32_t* out, const f32_t* in1, const f32_t* in2, f32_t factor, count_t size)
+{
+	f32_t inverse = 1.0f - factor;
+	NOIS_VEC k1 = NOIS_SET1(factor);
+	NOIS_VEC k2 = NOIS_SET1(inverse);
+	count_t i = 0;
+
+	for (; i + NOIS_WIDTH <= size; i += NOIS_WIDTH)
+	{
+		NOIS_STORE(out + i, NOIS_MULADD(NOIS_LOAD(in1 + i), k1, NOIS_MUL(NOIS_LOAD(in2 + i), k2)));
+	}
+
+	for (; i < size; ++i)
+	{
+		out[i] = in1[i] * factor + in2[i] * inverse;
+	}
+}
+
+NOIS_KERNEL_TARGET void AddMix(f32_t* out, const f32_t* in1, const f32_t* in2, f32_t factor, count_t size)
+{
+	f32_t inverse = 1.0f - factor;
+	NOIS_VEC k1 = NOIS_SET1(factor);
+	NOIS_VEC k2 = NOIS_SET1(inverse);
+	count_t i = 0;
+
+	for (; i + NOIS_WIDTH <= size; i += NOIS_WIDTH)
+	{
+		NOIS_VEC mixed = NOIS_MULADD(NOIS_LOAD(in1 + i), k1, NOIS_MUL(NOIS_LOAD(in2 + i), k2));
+		NOIS_STORE(out + i, NOIS_ADD(NOIS_LOAD(out + i), mixed));
+	}
+
+	for (; i < size; ++i)
+	{
+		out[i] += in1[i] * factor + in2[i] * inverse;
+	}
+}
+
+// Stereo is most of what hosts hand over, it gets a shuffle per vector
+NOIS_KERNEL_TARGET void Deinterleave(f32_t* out, count_t outChannelStride, const f32_t* in, count_t inFrameStride, count_t numFrames, count_t numChannels)
+{
+	count_t begin = 0;
+
+	if (numChannels == 2 && inFrameStride == 2)
+	{
+		f32_t* left = out;
+		f32_t* right = out + outChannelStride;
+
+		for (; begin + NOIS_WIDTH <= numFrames; begin += NOIS_WIDTH)
+		{
+			NOIS_VEC l;
+			NOIS_VEC r;
+			Deinterleave2(NOIS_LOAD(in + 2 * begin), NOIS_LOAD(in + 2 * begin + NOIS_WIDTH), l, r);
+			NOIS_STORE(left + begin, l);
+			NOIS_STORE(right + begin, r);
+		}
+	}
+
+	for (count_t c = 0; c < numChannels; ++c)
+	{
+		for (count_t f = begin; f < numFrames; ++f)
+		{
+			out[c * outChannelStride + f] = in[f * inFrameStride + c];
+		}
+	}
+}
+
+NOIS_KERNEL_TARGET void Interleave(f32_t* out, count_t outFrameStride, const f32_t* in, count_t inChannelStride, count_t numFrames, count_t numChannels)
+{
+	count_t begin = 0;
+
+	if (numChannels == 2 && outFrameStride == 2)
+	{
+		const f32_t* left = in;
+		const f32_t* right = in + inChannelStride;
+
+		for (; begin + NOIS_WIDTH <= numFrames; begin += NOIS_WIDTH)
+		{
+			NOIS_VEC a;
+			NOIS_VEC b;
+			Interleave2(NOIS_LOAD(left + begin), NOIS_LOAD(right + begin), a, b);
+			NOIS_STORE(out + 2 * begin, a);
+			NOIS_STORE(out + 2 * begin + NOIS_WIDTH, b);
+		}
+	}
+
+	for (count_t c = 0; c < numChannels; ++c)
+	{
+		for (count_t f = begin; f < numFrames; ++f)
+		{
+			out[f * outFrameStride + c] = in[c * inChannelStride + f];
+		}
+	}
+}
+
+constexpr Table k_Table = {
+	NOIS_KERNEL_ISA,
+	&Add,
+	&Sum,
+	&Subtract,
+	&Multiply,
+	&AddScaled,
+	&Scale,
+	&Mix,
+	&AddMix,
+	&Deinterleave,
+	&Interleave
+};
@@ -15,9 +15,33 @@ public:
 	{
 		NOIS_PROFILE_SCOPE();
 
-		f32_t ratio = m_Ratio.Get();
+		count_t numFrames = inBuffer.GetNumFrames();
 
-		for (count_t f = 0; f < m_NumFrames; ++f)
+		BlockSpan<f32_t> thresholdDb = m_ThresholdDbReader->Span();
+		BlockSpan<f32_t> attackMs = m_AttackMsReader->Span();
+		BlockSpan<f32_t> releaseMs = m_ReleaseMsReader->Span();
+		BlockSpan<f32_t> ratio = m_RatioReader->Span();
+
+		// Ballistics only follow block changes, they're smoothed by the envelope anyway
+		if (thresholdDb.changed)
+		{
+			m_Threshold = FromDb(thresholdDb[0]);
+		}
+
+		if (attackMs.changed)
+		{
+			m_AttackFactor = ToFactor(attackMs[0]);
+		}
+
+		if (releaseMs.changed)
+		{
+			m_ReleaseFactor = ToFactor(releaseMs[0]);
+		}
+
+		// A constant ratio gets the exponent hoisted out of the loop
+		f32_t exponent = 1.0f - 1.0f / ratio[0];
+
+		for (count_t f = 0; f < numFrames; ++f)
 		{
 			f32_t signal = 0.0f;
 
@@ -33,7 +57,12 @@ public:
 
 			if (m_Envelope > m_Threshold)
 			{
-				gain = std::pow(m_Threshold / m_Envelope, 1.0f - 1.0f / ratio);
+				if (!ratio.IsConstant())
+				{
+					exponent = 1.0f - 1.0f / ratio[f];
+				}
+
+				gain = std::pow(m_Threshold / m_Envelope, exponent);
 			}
 
 			for (count_t c = 0; c < m_NumChannels; ++c)
@@ -51,25 +80,35 @@ public:
 		f32_t sampleRate)
 	{
 		NOIS_PROFILE_SCOPE();
-		
-		if (m_ThresholdDb.PollChanged())
-		{
-			m_Threshold = FromDb(m_ThresholdDb.Get());
-		}
-		
-		if (m_AttackMs.PollChanged())
-		{
-			m_AttackFactor = 1.0f - std::exp(-1.0f / (m_AttackMs.Get() * 0.001f * sampleRate));
-		}
-		
-		if (m_ReleaseMs.PollChanged())
-		{
-			m_ReleaseFactor= 1.0f - std::exp(-1.0f / (m_ReleaseMs.Get() * 0.001f * sampleRate));
-		}
+
+		m_ThresholdDbReader = m_ThresholdDb.GetBlock();
+		m_RatioReader = m_Ratio.GetBlock();
+		m_AttackMsReader = m_AttackMs.GetBlock();
+		m_ReleaseMsReader = m_ReleaseMs.GetBlock();
 
 		m_NumFrames = numFrames;
 		m_NumChannels = numChannels;
 		m_SampleRate = sampleRate;
+
+		// Defaults never report a change, start from them
+		m_Threshold = FromDb(m_ThresholdDbReader->Span()[0]);
+		m_AttackFactor = ToFactor(m_AttackMsReader->Span()[0]);
+		m_ReleaseFactor = ToFactor(m_ReleaseMsReader->Span()[0]);
+	}
+
+	void Update()
+	{
+	}
+
+	// Silence still has to release the envelope, or the next sound starts out compressed
+	// Counts the frames the envelope takes to fall from full scale down to the threshold.
+	count_t GetTailFrames() const
+	{
+		// The envelope falls by a factor of e every release time constant
+		f32_t releaseFrames = -1.0f / std::log(1.0f - m_ReleaseFactor);
+		f32_t numTimeConstants = std::max(-std::log(m_Threshold), 0.0f);
+
+		return static_cast<count_t>(std::ceil(numTimeConstants * releaseFrames));
 	}
 
 	void SetRatio(Ref_t<FloatBlockParameter> ratio)
@@ -93,10 +132,21 @@ public:
 	}
 
 private:
-	FloatSlotBlockParameter m_ThresholdDb = { 0.0f, -96.0f, 0.0f };
-	FloatSlotBlockParameter m_Ratio = { 1.0f, 1.0f, 16.0f };
-	FloatSlotBlockParameter m_AttackMs = { 5.0f, 0.001f, 100.0f };
-	FloatSlotBlockParameter m_ReleaseMs = { 50.0f, 1.0f, 500.0f };
+	inline f32_t ToFactor(f32_t timeMs) const
+	{
+		return 1.0f - std::exp(-1.0f / (timeMs * 0.001f * m_SampleRate));
+	}
+
+private:
+	ParameterSlot<f32_t> m_ThresholdDb = { 0.0f, -96.0f, 0.0f };
+	ParameterSlot<f32_t> m_Ratio = { 1.0f, 1.0f, 16.0f };
+	ParameterSlot<f32_t> m_AttackMs = { 5.0f, 0.001f, 100.0f };
+	ParameterSlot<f32_t> m_ReleaseMs = { 50.0f, 1.0f, 500.0f };
+
+	Ref_t<IBlockReader<f32_t>> m_ThresholdDbReader = nullptr;
+	Ref_t<IBlockReader<f32_t>> m_RatioReader = nullptr;
+	Ref_t<IBlockReader<f32_t>> m_AttackMsReader = nullptr;
+	Ref_t<IBlockReader<f32_t>> m_ReleaseMsReader = nullptr;
 
 	f32_t m_Threshold = 0.0f;
 	f32_t m_AttackFactor = 1.0f;
@@ -109,6 +159,7 @@ private:
 };
 
 NOIS_INTERFACE_IMPL(Compressor)
+NOIS_INTERFACE_TAIL_IMPL(Compressor)
 NOIS_INTERFACE_PARAM_IMPL(Compressor, Ratio, FloatBlockParameter)
 NOIS_INTERFACE_PARAM_IMPL(Compressor, ThresholdDb, FloatBlockParameter)
 NOIS_INTERFACE_PARAM_IMPL(Compressor, AttackMs, FloatBlockParameter)
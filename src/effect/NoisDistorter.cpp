@@ -17,22 +17,46 @@ public:
 	{
 		NOIS_PROFILE_SCOPE();
 
-		f32_t drive = FromDb(m_DriveDb.Get());
-		f32_t makeup = FromDb(m_MakeupDb.Get());
-		f32_t wet = m_Wet.Get();
-		f32_t shape = m_Shape.Get();
-		f32_t asym = m_Asym.Get();
+		count_t numFrames = inBuffer.GetNumFrames();
+
+		BlockSpan<f32_t> driveDb = m_DriveDbReader->Span();
+		BlockSpan<f32_t> makeupDb = m_MakeupDbReader->Span();
+		BlockSpan<f32_t> wet = m_WetReader->Span();
+		BlockSpan<f32_t> shape = m_ShapeReader->Span();
+		BlockSpan<f32_t> asym = m_AsymReader->Span();
+
+		// Automation is nearly always constant over a block, hoist everything then
+		if (driveDb.IsConstant() &&
+			makeupDb.IsConstant() &&
+			wet.IsConstant() &&
+			shape.IsConstant() &&
+			asym.IsConstant())
+		{
+			ProcessConstant(
+				inBuffer,
+				outBuffer,
+				FromDb(driveDb[0]),
+				FromDb(makeupDb[0]),
+				wet[0],
+				shape[0],
+				asym[0]);
+
+			return Stream::Success;
+		}
 
-		for (count_t c = 0; c < m_NumChannels; ++c)
+		for (count_t f = 0; f < numFrames; ++f)
 		{
-			for (count_t f = 0; f < m_NumFrames; ++f)
+			f32_t drive = FromDb(driveDb[f]);
+			f32_t makeup = FromDb(makeupDb[f]);
+			f32_t k = 1.0f + shape[f];
+
+			for (count_t c = 0; c < m_NumChannels; ++c)
 			{
 				f32_t x = inBuffer(f, c);
 				f32_t d = drive * x;
-				f32_t s = d > 0.0f ? 1.0f : asym;
-				f32_t k = 1.0f + shape;
+				f32_t s = d > 0.0f ? 1.0f : asym[f];
 				f32_t y = FastTanh(d * s * k);
-				outBuffer(f, c) = makeup * (x + (y - x) * wet);
+				outBuffer(f, c) = makeup * (x + (y - x) * wet[f]);
 			}
 		}
 
@@ -46,10 +70,20 @@ public:
 	{
 		NOIS_PROFILE_SCOPE();
 
+		m_DriveDbReader = m_DriveDb.GetBlock();
+		m_MakeupDbReader = m_MakeupDb.GetBlock();
+		m_WetReader = m_Wet.GetBlock();
+		m_ShapeReader = m_Shape.GetBlock();
+		m_AsymReader = m_Asym.GetBlock();
+
 		m_NumFrames = numFrames;
 		m_NumChannels = numChannels;
 	}
 
+	void Update()
+	{
+	}
+
 	void SetDriveDb(Ref_t<FloatBlockParameter> driveDb)
 	{
 		m_DriveDb.Use(driveDb);
@@ -76,11 +110,44 @@ public:
 	}
 
 private:
-	SlotBlockParameter<f32_t> m_DriveDb = { 0.0f, 0.0f, 12.0f };
-	SlotBlockParameter<f32_t> m_MakeupDb = { 0.0f, -12.0f, 0.0f };
-	SlotBlockParameter<f32_t> m_Wet = { 1.0f, 0.0f, 1.0f };
-	SlotBlockParameter<f32_t> m_Shape = { 0.0f, -1.0f, 1.0f };
-	SlotBlockParameter<f32_t> m_Asym = { 1.0f, 1.0f, 4.0f };
+	inline void ProcessConstant(
+		ConstFloatBufferView inBuffer,
+		FloatBufferView outBuffer,
+		f32_t drive,
+		f32_t makeup,
+		f32_t wet,
+		f32_t shape,
+		f32_t asym)
+	{
+		count_t numFrames = inBuffer.GetNumFrames();
+		f32_t k = 1.0f + shape;
+
+		for (count_t c = 0; c < m_NumChannels; ++c)
+		{
+			for (count_t f = 0; f < numFrames; ++f)
+			{
+				f32_t x = inBuffer(f, c);
+				f32_t d = drive * x;
+				f32_t s = d > 0.0f ? 1.0f : asym;
+				f32_t y = FastTanh(d * s * k);
+				outBuffer(f, c) = makeup * (x + (y - x) * wet);
+			}
+		}
+	}
+
+private:
+	ParameterSlot<f32_t> m_DriveDb = { 0.0f, 0.0f, 12.0f };
+	ParameterSlot<f32_t> m_MakeupDb = { 0.0f, -12.0f, 0.0f };
+	ParameterSlot<f32_t> m_Wet = { 1.0f, 0.0f, 1.0f };
+	ParameterSlot<f32_t> m_Shape = { 0.0f, -1.0f, 1.0f };
+	ParameterSlot<f32_t> m_Asym = { 1.0f, 1.0f, 4.0f };
+
+	Ref_t<IBlockReader<f32_t>> m_DriveDbReader = nullptr;
+	Ref_t<IBlockReader<f32_t>> m_MakeupDbReader = nullptr;
+	Ref_t<IBlockReader<f32_t>> m_WetReader = nullptr;
+	Ref_t<IBlockReader<f32_t>> m_ShapeReader = nullptr;
+	Ref_t<IBlockReader<f32_t>> m_AsymReader = nullptr;
+
 	count_t m_NumFrames = 0;
 	count_t m_NumChannels = 0;
 };
@@ -14,8 +14,13 @@ public:
 		ConstFloatBufferView inBuffer,
 		FloatBufferView outBuffer)
 	{
-		outBuffer.Copy(inBuffer);
-		outBuffer.Multiply(m_Gain);
+		if (outBuffer.Data() != inBuffer.Data())
+		{
+			outBuffer.Copy(inBuffer);
+		}
+
+		// Broadcasts constant gain, ramps and per-sample gain get their own kernels
+		outBuffer.Multiply(m_GainReader->Span());
 
 		return Stream::Success;
 	}
@@ -24,6 +29,11 @@ public:
 		count_t numFrames,
 		count_t numChannels,
 		f32_t sampleRate)
+	{
+		m_GainReader = m_Gain.GetBlock();
+	}
+
+	void Update()
 	{
 	}
 
@@ -33,7 +43,8 @@ public:
 	}
 
 private:
-	FloatSlotParameter m_Gain;
+	ParameterSlot<f32_t> m_Gain;
+	Ref_t<IBlockReader<f32_t>> m_GainReader = nullptr;
 };
 
 NOIS_INTERFACE_IMPL(Gainer)
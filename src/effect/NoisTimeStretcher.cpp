@@ -3,6 +3,7 @@
 #include "NoisLog.h"
 #include "NoisMacros.hpp"
 #include "nois/util/NoisDelay.hpp"
+#include "nois/util/NoisSmoothingBank.hpp"
 
 namespace nois {
 
@@ -20,15 +21,20 @@ public:
 	{
 		NOIS_PROFILE_SCOPE();
 
-		m_Delay.Configure(static_cast<count_t>(5.0f * sampleRate));
+		m_NumDelayFrames = static_cast<count_t>(5.0f * sampleRate);
+		m_Delay.Configure(m_NumDelayFrames);
 
-		m_StretchTimeMsReader = m_StretchTimeMs.Get();
-		m_StretchActiveReader = m_StretchActive.Get();
-		m_StretchFactorReader = MakeRef<SmoothedStreamReader<f32_t>>(m_StretchFactor.Get(), sampleRate, 0.01f);
-		m_GrainSizeReader = MakeRef<SmoothedStreamReader<f32_t>>(m_GrainSize.Get(), sampleRate, 0.01f);
-		m_GrainBlendReader = MakeRef<SmoothedStreamReader<f32_t>>(m_GrainBlend.Get(), sampleRate, 0.01f);
-		m_GrainPhaseIncReader = MakeRef<SmoothedStreamReader<f32_t>>(m_GrainPhaseInc.Get(), sampleRate, 0.01f);
-		m_GrainLockActiveReader = m_GrainLockActive.Get();
+		m_StretchTimeMsReader = m_StretchTimeMs.GetBlock();
+		m_StretchActiveReader = m_StretchActive.GetBlock();
+		m_GrainLockActiveReader = m_GrainLockActive.GetBlock();
+
+		// All four smoothed controls share one quad
+		m_Smoothing.Clear();
+		m_StretchFactorLane = m_Smoothing.Add(m_StretchFactor.GetBlock(), 0.01f);
+		m_GrainSizeLane = m_Smoothing.Add(m_GrainSize.GetBlock(), 0.01f);
+		m_GrainBlendLane = m_Smoothing.Add(m_GrainBlend.GetBlock(), 0.01f);
+		m_GrainPhaseIncLane = m_Smoothing.Add(m_GrainPhaseInc.GetBlock(), 0.01f);
+		m_Smoothing.Prepare(numFrames, sampleRate);
 
 		m_NumFrames = numFrames;
 		m_NumChannels = numChannels;
@@ -46,15 +52,28 @@ public:
 	{
 		NOIS_PROFILE_SCOPE_NAMED("Process TimeStretcher");
 
-		for (count_t f = 0; f < m_NumFrames; ++f)
+		count_t numFrames = inBuffer.GetNumFrames();
+
+		// One read per parameter for the whole block
+		BlockSpan<f32_t> stretchTimeMsSpan = m_StretchTimeMsReader->Span();
+		BlockSpan<f32_t> stretchActiveSpan = m_StretchActiveReader->Span();
+		BlockSpan<f32_t> grainLockActiveSpan = m_GrainLockActiveReader->Span();
+
+		m_Smoothing.Process(numFrames);
+		BlockSpan<f32_t> stretchFactorSpan = m_Smoothing.Span(m_StretchFactorLane);
+		BlockSpan<f32_t> grainSizeSpan = m_Smoothing.Span(m_GrainSizeLane);
+		BlockSpan<f32_t> grainBlendSpan = m_Smoothing.Span(m_GrainBlendLane);
+		BlockSpan<f32_t> grainPhaseIncSpan = m_Smoothing.Span(m_GrainPhaseIncLane);
+
+		for (count_t f = 0; f < numFrames; ++f)
 		{
-			auto stretchTimeMs = m_StretchTimeMsReader->Next();
-			auto stretchActive = m_StretchActiveReader->Next();
-			auto grainLockActive = m_GrainLockActiveReader->Next();
-			auto stretchFactor = m_StretchFactorReader->Next();
-			auto grainSize = m_GrainSizeReader->Next();
-			auto grainBlend = m_GrainBlendReader->Next();
-			auto grainPhaseInc = m_GrainPhaseIncReader->Next();
+			f32_t stretchTimeMs = stretchTimeMsSpan[f];
+			f32_t stretchActive = stretchActiveSpan[f];
+			f32_t grainLockActive = grainLockActiveSpan[f];
+			f32_t stretchFactor = stretchFactorSpan[f];
+			f32_t grainSize = grainSizeSpan[f];
+			f32_t grainBlend = grainBlendSpan[f];
+			f32_t grainPhaseInc = grainPhaseIncSpan[f];
 
 			// Enable stretch if it became active this frame
 			if (!m_IsStretchActive &&
@@ -124,6 +143,13 @@ public:
 		return Stream::Success;
 	}
 
+	count_t GetTailFrames() const
+	{
+		// Stretching replays recorded input for as long as it's held, otherwise
+		// the recording only matters until silence has filled it
+		return m_IsStretchActive ? Stream::k_InfiniteTail : m_NumDelayFrames;
+	}
+
 	void SetStretchTimeMs(Ref_t<FloatParameter> stretchTimeMs)
 	{
 		m_StretchTimeMs.Use(stretchTimeMs);
@@ -300,13 +326,15 @@ private:
 	ParameterSlot<f32_t> m_GrainPhaseInc = 1.0f;
 	ParameterSlot<f32_t> m_GrainLockActive = 0.0f;
 
-	Ref_t<IStreamReader<f32_t>> m_StretchTimeMsReader = nullptr;
-	Ref_t<IStreamReader<f32_t>> m_StretchActiveReader = nullptr;
-	Ref_t<IStreamReader<f32_t>> m_StretchFactorReader = nullptr;
-	Ref_t<IStreamReader<f32_t>> m_GrainSizeReader = nullptr;
-	Ref_t<IStreamReader<f32_t>> m_GrainBlendReader = nullptr;
-	Ref_t<IStreamReader<f32_t>> m_GrainPhaseIncReader = nullptr;
-	Ref_t<IStreamReader<f32_t>> m_GrainLockActiveReader = nullptr;
+	Ref_t<IBlockReader<f32_t>> m_StretchTimeMsReader = nullptr;
+	Ref_t<IBlockReader<f32_t>> m_StretchActiveReader = nullptr;
+	Ref_t<IBlockReader<f32_t>> m_GrainLockActiveReader = nullptr;
+
+	SmoothingBank m_Smoothing;
+	count_t m_StretchFactorLane = 0;
+	count_t m_GrainSizeLane = 0;
+	count_t m_GrainBlendLane = 0;
+	count_t m_GrainPhaseIncLane = 0;
 
 	bool m_IsStretchActive = false;
 	bool m_IsGrainLockActive = false;
@@ -317,6 +345,7 @@ private:
 	std::array<count_t, k_MaxChannels> m_GrainBases = { 0 };
 	f32_t m_StetchNumFrames = 0.0f;
 	Delay<f32_t, k_MaxChannels> m_Delay;
+	count_t m_NumDelayFrames = 0;
 
 	count_t m_NumFrames = 0;
 	count_t m_NumChannels = 0;
@@ -329,6 +358,7 @@ Ref_t<TimeStretcher> TimeStretcher::Create()
 }
 
 NOIS_INTERFACE_IMPL(TimeStretcher)
+NOIS_INTERFACE_TAIL_IMPL(TimeStretcher)
 NOIS_INTERFACE_PARAM_IMPL(TimeStretcher, StretchTimeMs, FloatParameter)
 NOIS_INTERFACE_PARAM_IMPL(TimeStretcher, StretchActive, FloatParameter)
 NOIS_INTERFACE_PARAM_IMPL(TimeStretcher, StretchFactor, FloatParameter)
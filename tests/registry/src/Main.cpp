@@ -0,0 +1,2135 @@
+#include <nois/Nois.hpp>
+
+// Checks stay on in every build type, some of them run the graph
+#undef NDEBUG
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <numbers>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Result = nois::FloatRegistry::Result;
+
+// Counts heap allocations so realtime paths can be checked for them
+// Every replaceable form goes through the same pair, so new and delete always match.
+static std::atomic<int> g_NumAllocations = 0;
+
+// Allocations of the calling thread alone, for threads running next to others
+static thread_local int t_NumAllocations = 0;
+
+static void* CountedAllocate(std::size_t size)
+{
+	g_NumAllocations.fetch_add(1, std::memory_order_relaxed);
+	++t_NumAllocations;
+
+	if (void* memory = std::malloc(size))
+	{
+		return memory;
+	}
+
+	throw std::bad_alloc();
+}
+
+static void CountedFree(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void* operator new(std::size_t size)
+{
+	return CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return CountedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	CountedFree(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	CountedFree(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	CountedFree(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	CountedFree(memory);
+}
+
+// Adds a constant to every sample and records when it was processed
+class OffsetStream : public nois::Stream<nois::f32_t>
+{
+public:
+	OffsetStream(nois::f32_t offset, std::vector<OffsetStream*>* order, bool inPlace)
+		: offset(offset)
+		, order(order)
+		, inPlace(inPlace)
+	{
+	}
+
+	static nois::Ref_t<OffsetStream> Create(nois::f32_t offset, std::vector<OffsetStream*>* order = nullptr, bool inPlace = false)
+	{
+		return nois::MakeRef<OffsetStream>(offset, order, inPlace);
+	}
+
+	bool SupportsInPlace() const override
+	{
+		return inPlace;
+	}
+
+	nois::count_t GetTailFrames() const override
+	{
+		return tailFrames;
+	}
+
+	void Prepare(nois::count_t numFrames, nois::count_t numChannels, nois::f32_t sampleRate) override
+	{
+		++numPrepares;
+	}
+
+	void Update() override
+	{
+		++numUpdates;
+	}
+
+	Result Process(nois::ConstFloatBufferView inBuffer, nois::FloatBufferView outBuffer) override
+	{
+		for (nois::count_t i = 0; i < outBuffer.GetSize(); ++i)
+		{
+			outBuffer[i] = inBuffer[i] + offset;
+		}
+
+		if (order)
+		{
+			order->push_back(this);
+		}
+
+		++numProcesses;
+
+		return Success;
+	}
+
+	nois::f32_t offset;
+	std::vector<OffsetStream*>* order;
+	bool inPlace;
+	nois::count_t tailFrames = k_InfiniteTail;
+	int numPrepares = 0;
+	int numUpdates = 0;
+	int numProcesses = 0;
+};
+
+// Delays its input by a fixed number of frames and reports it as latency
+class DelayStream : public nois::Stream<nois::f32_t>
+{
+public:
+	DelayStream(nois::count_t numDelayFrames)
+		: numDelayFrames(numDelayFrames)
+	{
+	}
+
+	static nois::Ref_t<DelayStream> Create(nois::count_t numDelayFrames)
+	{
+		return nois::MakeRef<DelayStream>(numDelayFrames);
+	}
+
+	nois::count_t GetLatencyFrames() const override
+	{
+		++numLatencyQueries;
+		return numDelayFrames;
+	}
+
+	void Prepare(nois::count_t numFrames, nois::count_t numChannels, nois::f32_t sampleRate) override
+	{
+		line.assign(numDelayFrames * numChannels, 0.0f);
+		position = 0;
+	}
+
+	void Update() override
+	{
+	}
+
+	Result Process(nois::ConstFloatBufferView inBuffer, nois::FloatBufferView outBuffer) override
+	{
+		for (nois::count_t f = 0; f < outBuffer.GetNumFrames(); ++f)
+		{
+			for (nois::count_t c = 0; c < outBuffer.GetNumChannels(); ++c)
+			{
+				nois::f32_t& sample = line[position * outBuffer.GetNumChannels() + c];
+				outBuffer(f, c) = sample;
+				sample = inBuffer(f, c);
+			}
+
+			position = (position + 1) % numDelayFrames;
+		}
+
+		return Success;
+	}
+
+	nois::count_t numDelayFrames;
+	std::vector<nois::f32_t> line;
+	nois::count_t position = 0;
+	mutable int numLatencyQueries = 0;
+};
+
+static nois::FloatBuffer MakeInput(nois::count_t numFrames, nois::count_t numChannels, nois::f32_t value)
+{
+	nois::FloatBuffer buffer(numFrames, numChannels);
+	buffer.Fill(value);
+	return buffer;
+}
+
+static void test_registry_chain_order()
+{
+	std::vector<OffsetStream*> order;
+
+	nois::FloatRegistry registry;
+
+	// Created out of order on purpose, the schedule must still be topological
+	auto c = registry.CreateStream<OffsetStream>(100.0f, &order);
+	auto b = registry.CreateStream<OffsetStream>(10.0f, &order);
+	auto a = registry.CreateStream<OffsetStream>(1.0f, &order);
+
+	registry.Connect(a, b);
+	registry.Connect(b, c);
+	registry.SetSink(c);
+
+	auto in = MakeInput(64, 2, 0.5f);
+	nois::FloatBuffer out(64, 2);
+
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	assert(order.size() == 3);
+	assert(order[0] == a.get());
+	assert(order[1] == b.get());
+	assert(order[2] == c.get());
+
+	for (nois::count_t i = 0; i < out.GetSize(); ++i)
+	{
+		assert(out[i] == 111.5f);
+	}
+
+	// Running again must not re-prepare
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(a->numPrepares == 1);
+	assert(a->numUpdates == 2);
+
+	// Edits stay staged until they're committed
+	order.clear();
+	auto d = registry.CreateStream<OffsetStream>(1000.0f, &order);
+	registry.Connect(c, d);
+	registry.SetSink(d);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	assert(order.size() == 3);
+	assert(out[0] == 111.5f);
+
+	order.clear();
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	assert(order.size() == 4);
+	assert(order.back() == d.get());
+	assert(out[0] == 1111.5f);
+
+	// Swapping plans only prepares the nodes that are new
+	assert(a->numPrepares == 1);
+	assert(d->numPrepares == 1);
+}
+
+static void test_registry_parameters()
+{
+	nois::FloatRegistry registry;
+
+	nois::f32_t bound = 2.0f;
+	auto binder = registry.CreateBlockBinder(
+		[&bound]()
+		{
+			return bound;
+		});
+	auto doubled = binder->Transform(
+		[](nois::f32_t x)
+		{
+			return x * 2.0f;
+		});
+
+	// Only what a slot reads gets evaluated
+	nois::ParameterSlot<nois::f32_t> slot = 0.0f;
+	slot.Use(doubled);
+
+	auto in = MakeInput(16, 1, 0.0f);
+	// There is no sink, Run() only updates parameters
+	nois::FloatBuffer out(16, 1);
+
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Starved);
+
+	auto reader = doubled->Block();
+	assert(reader->Get(0).Value() == 4.0f);
+
+	bound = 3.0f;
+	assert(registry.Run(in, out, 48000.0f) == Result::Starved);
+	assert(reader->Get(15).Value() == 6.0f);
+}
+
+static void test_registry_block_spans()
+{
+	nois::FloatRegistry registry;
+
+	nois::f32_t bound = 2.0f;
+	auto block = registry.CreateBlockBinder(
+		[&bound]()
+		{
+			return bound;
+		});
+	auto ramp = registry.CreateSampleBinder(
+		[](nois::count_t f)
+		{
+			return static_cast<nois::f32_t>(f);
+		});
+	auto doubled = block->Transform(
+		[](nois::f32_t x)
+		{
+			return x * 2.0f;
+		});
+
+	nois::ParameterSlot<nois::f32_t> rampSlot = 0.0f;
+	nois::ParameterSlot<nois::f32_t> doubledSlot = 0.0f;
+	rampSlot.Use(ramp);
+	doubledSlot.Use(doubled);
+
+	auto in = MakeInput(16, 1, 0.0f);
+	// There is no sink, Run() only updates parameters
+	nois::FloatBuffer out(16, 1);
+
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Starved);
+
+	auto blockSpan = block->Block()->Span();
+	assert(blockSpan.IsConstant() && blockSpan.numFrames == 16);
+	assert(blockSpan[15] == 2.0f);
+
+	auto rampSpan = ramp->Block()->Span();
+	assert(!rampSpan.IsConstant() && rampSpan.numFrames == 16);
+	assert(rampSpan.values[7] == 7.0f && rampSpan[15] == 15.0f);
+
+	// Transforming a constant block keeps it constant
+	auto doubledReader = doubled->Block();
+	assert(doubledReader->Span().IsConstant() && doubledReader->Span()[3] == 4.0f);
+
+	assert(registry.Run(in, out, 48000.0f) == Result::Starved);
+	assert(!doubledReader->Span().changed);
+
+	bound = 3.0f;
+	assert(registry.Run(in, out, 48000.0f) == Result::Starved);
+	assert(doubledReader->Span().changed && doubledReader->Span()[0] == 6.0f);
+
+	// Slots hand out the default until a parameter is used, then flag the swap
+	nois::ParameterSlot<nois::f32_t> slot = 0.5f;
+	auto slotReader = slot.GetBlock();
+	assert(slotReader->Span().IsConstant() && slotReader->Span()[9] == 0.5f);
+
+	slot.Use(ramp);
+	auto slotSpan = slotReader->Span();
+	assert(slotSpan.changed && slotSpan[5] == 5.0f);
+}
+
+static void test_registry_automation()
+{
+	nois::FloatRegistry registry;
+
+	auto automation = registry.CreateAutomation(1.0f);
+	auto gainer = registry.CreateStream<nois::Gainer>();
+	gainer->SetGain(automation);
+	registry.SetSink(gainer);
+
+	auto in = MakeInput(4096, 1, 1.0f);
+	nois::FloatBuffer out(4096, 1);
+
+	// Two breakpoints are three segments, not a value per frame
+	using Ramp = nois::FloatAutomationParameter::Ramp;
+	automation->Add(1024, 3.0f, Ramp::Linear);
+	automation->Add(3072, 0.5f, Ramp::Step);
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	auto segments = automation->Segments();
+	assert(segments.size() == 3);
+	assert(segments[0].end == 1024 && segments[1].value == 3.0f && segments[2].begin == 3072);
+	assert(std::abs(out[512] - 2.0f) < 1e-5f && out[1024] == 3.0f && out[3071] == 3.0f && out[3072] == 0.5f);
+
+	// Quiet blocks are constant spans without rendering
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	auto span = automation->Block()->Span();
+	assert(span.IsConstant() && !span.changed && span[0] == 0.5f);
+
+	// Breakpoints past the block ramp towards it and carry over
+	automation->Add(6000, 4.5f, Ramp::Linear);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(automation->Segments().size() == 1);
+	assert(std::abs(out[4095] - (0.5f + 4095.0f * 4.0f / 6000.0f)) < 1e-4f);
+
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(std::abs(out[1903] - (4.5f - 4.0f / 6000.0f)) < 1e-4f && out[1904] == 4.5f && out[4095] == 4.5f);
+	assert(automation->GetLastValue() == 4.5f);
+
+	// Capacity is fixed up front
+	auto small = registry.CreateAutomation(0.0f, 2);
+	assert(small->Add(0, 1.0f) && small->Add(1, 2.0f) && !small->Add(2, 3.0f));
+
+	// Unread automation still moves on, passed breakpoints free their room
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(small->Add(2048, 3.0f, Ramp::Linear) && small->Add(8192, 0.0f));
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	gainer->SetGain(small);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(out[0] == 3.0f && out[4095] == 3.0f);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(out[0] == 0.0f);
+
+	// Overfilling a block keeps the first points and lands on the last one
+	for (nois::count_t f = 0; f < 16; ++f)
+	{
+		small->AddOrReplaceLast(f * 256, static_cast<nois::f32_t>(f));
+	}
+
+	assert(small->GetLastValue() == 15.0f);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(out[0] == 0.0f && out[3839] == 0.0f && out[3840] == 15.0f && out[4095] == 15.0f);
+}
+
+static void test_registry_expression()
+{
+	std::string error;
+	assert(!nois::Expression::Compile("db(x", &error) && error.find("column") != std::string::npos);
+	assert(!nois::Expression::Compile("foo(x)", &error) && error.find("foo") != std::string::npos);
+	assert(!nois::Expression::Compile("min(x)", &error));
+	assert(!nois::Expression::Compile("2 +", &error));
+	assert(!nois::Expression::Compile("1.2.3", &error) && error.find("malformed number") != std::string::npos);
+
+	// Constants fold away, a constant program fills the block
+	auto folded = nois::Expression::Compile("2 * 3 + -6db / -6db");
+	assert(folded && folded->GetNumInputs() == 0 && !folded->IsTimeVarying());
+
+	nois::f32_t values[100] = {};
+	folded->Process(values, 100, nullptr, 48000.0f);
+	assert(std::all_of(values, values + 100, [](nois::f32_t v) { return std::abs(v - 7.0f) <= 1e-6f; }));
+
+	// An inverted clamp folds to the upper bound, same as it runs per block
+	auto inverted = nois::Expression::Compile("clamp(5, 3, 1)");
+	assert(inverted);
+	inverted->Process(values, 100, nullptr, 48000.0f);
+	assert(values[0] == 1.0f && values[99] == 1.0f);
+
+	nois::FloatRegistry registry;
+
+	auto ramp = registry.CreateSampleBinder(
+		[](nois::count_t f)
+		{
+			return -60.0f + 0.5f * static_cast<nois::f32_t>(f);
+		});
+	auto fixed = registry.CreateBlockBinder(
+		[]()
+		{
+			return 0.25f;
+		});
+
+	auto gain = registry.CreateExpression(nois::Expression::Compile("db(x) * 2 + y"), ramp, fixed);
+	auto tremolo = registry.CreateExpression(nois::Expression::Compile("0.5 + 0.5 * lfo(1khz)"));
+	auto cutoff = registry.CreateExpression(nois::Expression::Compile("clamp(x * sr / 100, 20hz, 1khz)"), fixed);
+
+	// Input count has to match the names the expression uses
+	assert(!registry.CreateExpression(nois::Expression::Compile("x * y"), fixed));
+	assert(gain && tremolo && cutoff);
+
+	nois::ParameterSlot<nois::f32_t> slots[3] = { 0.0f, 0.0f, 0.0f };
+	slots[0].Use(gain);
+	slots[1].Use(tremolo);
+	slots[2].Use(cutoff);
+
+	auto in = MakeInput(150, 1, 1.0f);
+	nois::FloatBuffer out(150, 1);
+	registry.SetSink(registry.CreateStream<nois::Gainer>());
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	// Spans the chunk boundaries and the SIMD tail
+	auto gainSpan = gain->Block()->Span();
+	auto tremoloSpan = tremolo->Block()->Span();
+
+	for (nois::count_t f = 0; f < 150; ++f)
+	{
+		nois::f32_t expected = nois::FromDb(-60.0f + 0.5f * static_cast<nois::f32_t>(f)) * 2.0f + 0.25f;
+		nois::f32_t phase = std::fmod(static_cast<nois::f32_t>(f) * 1000.0f / 48000.0f, 1.0f);
+
+		assert(std::abs(gainSpan[f] - expected) <= 1e-5f * expected);
+		assert(std::abs(tremoloSpan[f] - (0.5f + 0.5f * std::sin(2.0f * std::numbers::pi_v<nois::f32_t> * phase))) <= 1e-4f);
+	}
+
+	// Oscillators aren't constant without inputs, constant inputs are
+	assert(!tremoloSpan.IsConstant());
+	auto cutoffSpan = cutoff->Block()->Span();
+	assert(cutoffSpan.IsConstant() && cutoffSpan[0] == 120.0f);
+}
+
+struct CountingScale
+{
+	int* numCalls = nullptr;
+	nois::f32_t scale = 1.0f;
+
+	bool operator==(const CountingScale&) const = default;
+
+	void operator()(nois::f32_t* out, nois::count_t numFrames, const nois::BlockSpan<nois::f32_t>& in)
+	{
+		++*numCalls;
+
+		for (nois::count_t f = 0; f < numFrames; ++f)
+		{
+			out[f] = in[f] * scale;
+		}
+	}
+};
+
+static void test_registry_shared_transform()
+{
+	nois::FloatRegistry registry;
+
+	auto ramp = registry.CreateSampleBinder(
+		[](nois::count_t f)
+		{
+			return static_cast<nois::f32_t>(f);
+		});
+	auto other = registry.CreateSampleBinder(
+		[](nois::count_t f)
+		{
+			return static_cast<nois::f32_t>(f);
+		});
+
+	// Equal mappings of one parameter are one parameter
+	auto percent = ramp->TransformBlock(nois::mapping::ScaleOffset{ 0.01f, 0.0f });
+	assert(ramp->TransformBlock(nois::mapping::ScaleOffset{ 0.01f, 0.0f }) == percent);
+	assert(ramp->TransformBlock(nois::mapping::ScaleOffset{ 0.02f, 0.0f }) != percent);
+	assert(other->TransformBlock(nois::mapping::ScaleOffset{ 0.01f, 0.0f }) != percent);
+	assert(ramp->TransformBlock(nois::mapping::DbToLinear{}) == ramp->TransformBlock(nois::mapping::DbToLinear{}));
+
+	// Lambdas never compare equal
+	assert(ramp->Transform([](nois::f32_t x) { return x * 0.5f; }) != ramp->Transform([](nois::f32_t x) { return x * 0.5f; }));
+
+	// A transform with its own control interval isn't handed to the next caller
+	auto coarse = ramp->TransformBlock(nois::mapping::ScaleOffset{ 0.5f, 0.0f });
+	assert(ramp->TransformBlock(nois::mapping::ScaleOffset{ 0.5f, 0.0f }) == coarse);
+	coarse->SetControlInterval(64);
+
+	auto fine = ramp->TransformBlock(nois::mapping::ScaleOffset{ 0.5f, 0.0f });
+	assert(fine != coarse);
+	assert(fine->GetControlInterval() == nois::Parameter<nois::f32_t>::k_DefaultControlInterval);
+	assert(coarse->GetControlInterval() == 64);
+	assert(ramp->TransformBlock(nois::mapping::ScaleOffset{ 0.5f, 0.0f }) == fine);
+
+	// Expressions are shared when they're the same compiled expression
+	auto expression = nois::Expression::Compile("x * 2");
+	assert(registry.CreateExpression(expression, ramp) == registry.CreateExpression(expression, ramp));
+	assert(registry.CreateExpression(expression, ramp) != registry.CreateExpression(nois::Expression::Compile("x * 2"), ramp));
+
+	// Shared transforms run once per block however many times they were created
+	int numCalls = 0;
+	auto first = ramp->TransformBlock(CountingScale{ &numCalls, 3.0f });
+	auto second = ramp->TransformBlock(CountingScale{ &numCalls, 3.0f });
+	assert(first == second);
+
+	nois::ParameterSlot<nois::f32_t> slots[2] = { 0.0f, 0.0f };
+	slots[0].Use(first);
+	slots[1].Use(second);
+
+	auto in = MakeInput(64, 1, 1.0f);
+	nois::FloatBuffer out(64, 1);
+	registry.SetSink(registry.CreateStream<nois::Gainer>());
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	assert(numCalls == 1);
+	assert(second->Block()->Span()[10] == 30.0f);
+}
+
+static void test_buffer_kernels()
+{
+	// Odd sizes so every variant runs its vector loop and its tail
+	constexpr nois::count_t k_NumFrames = 37;
+	constexpr nois::count_t k_Size = k_NumFrames * 2;
+
+	nois::FloatBuffer a(k_NumFrames, 2);
+	nois::FloatBuffer b(k_NumFrames, 2);
+
+	for (nois::count_t i = 0; i < k_Size; ++i)
+	{
+		a[i] = std::sin(0.1f * static_cast<nois::f32_t>(i));
+		b[i] = 0.5f - 0.01f * static_cast<nois::f32_t>(i);
+	}
+
+	auto isClose = [](const nois::FloatBuffer& buffer, auto&& expected)
+	{
+		for (nois::count_t i = 0; i < k_Size; ++i)
+		{
+			if (std::abs(buffer[i] - expected(i)) > 1e-6f)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	nois::kernel::Isa best = nois::kernel::GetBestIsa();
+	nois::count_t numTested = 0;
+
+	for (nois::kernel::Isa isa : { nois::kernel::Isa::Scalar, nois::kernel::Isa::Sse2, nois::kernel::Isa::Avx2, nois::kernel::Isa::Avx512, nois::kernel::Isa::Neon })
+	{
+		if (!nois::kernel::Select(isa))
+		{
+			continue;
+		}
+
+		assert(nois::kernel::Get().isa == isa);
+		++numTested;
+
+		nois::FloatBuffer out(k_NumFrames, 2);
+		nois::FloatBufferView view = out;
+
+		out.Copy(a);
+		out.Add(b);
+		assert(isClose(out, [&](nois::count_t i) { return a[i] + b[i]; }));
+
+		out.Sum(a, b);
+		assert(isClose(out, [&](nois::count_t i) { return a[i] + b[i]; }));
+
+		out.Subtract(b);
+		out.Subtract(b);
+		assert(isClose(out, [&](nois::count_t i) { return a[i] - b[i]; }));
+
+		out.Multiply(3.0f);
+		assert(isClose(out, [&](nois::count_t i) { return (a[i] - b[i]) * 3.0f; }));
+
+		view.Copy(a, 0.25f);
+		assert(isClose(out, [&](nois::count_t i) { return a[i] * 0.25f; }));
+
+		view.Add(b, 2.0f);
+		assert(isClose(out, [&](nois::count_t i) { return a[i] * 0.25f + b[i] * 2.0f; }));
+
+		view.Copy(a);
+		view.CopyLinearily(b, 0.3f);
+		assert(isClose(out, [&](nois::count_t i) { return a[i] * 0.3f + b[i] * 0.7f; }));
+
+		out.Zero();
+		view.AddLinearily(a, b, 0.8f);
+		view.AddLinearily(a, b, 0.8f);
+		assert(isClose(out, [&](nois::count_t i) { return 2.0f * (a[i] * 0.8f + b[i] * 0.2f); }));
+
+		// Shorter inputs only touch their own length
+		out.Zero();
+		view.Add(a.View(0));
+		assert(out[k_NumFrames - 1] == a[k_NumFrames - 1] && out[k_NumFrames] == 0.0f);
+	}
+
+	assert(numTested >= 2);
+	assert(!nois::kernel::Select(static_cast<nois::kernel::Isa>(99)));
+	assert(nois::kernel::Select(best) && nois::kernel::Get().isa == best);
+	assert(std::string(nois::kernel::GetName(best)) != "Unknown");
+}
+
+static void test_buffer_strided_view()
+{
+	constexpr nois::count_t k_NumFrames = 37;
+
+	std::vector<nois::f32_t> interleaved(k_NumFrames * 3);
+
+	for (nois::count_t i = 0; i < static_cast<nois::count_t>(interleaved.size()); ++i)
+	{
+		interleaved[i] = static_cast<nois::f32_t>(i);
+	}
+
+	nois::kernel::Isa best = nois::kernel::GetBestIsa();
+
+	// Stereo takes the shuffle kernels, three channels the plain loops
+	for (nois::kernel::Isa isa : { nois::kernel::Isa::Scalar, nois::kernel::Isa::Sse2, nois::kernel::Isa::Avx2, nois::kernel::Isa::Avx512, nois::kernel::Isa::Neon })
+	{
+		if (!nois::kernel::Select(isa))
+		{
+			continue;
+		}
+
+		for (nois::count_t numChannels = 1; numChannels <= 3; ++numChannels)
+		{
+			auto view = nois::StridedFloatBufferView::Interleaved(interleaved.data(), k_NumFrames, numChannels);
+			assert(view.IsInterleaved() == (numChannels > 1) && view.IsPlanar() == (numChannels == 1));
+
+			nois::FloatBuffer planar(k_NumFrames, numChannels);
+			view.CopyTo(planar);
+
+			for (nois::count_t c = 0; c < numChannels; ++c)
+			{
+				for (nois::count_t f = 0; f < k_NumFrames; ++f)
+				{
+					assert(planar(f, c) == static_cast<nois::f32_t>(f * numChannels + c));
+				}
+			}
+
+			std::vector<nois::f32_t> roundTrip(k_NumFrames * numChannels, -1.0f);
+			nois::StridedFloatBufferView::Interleaved(roundTrip.data(), k_NumFrames, numChannels).CopyFrom(planar);
+			assert(std::equal(roundTrip.begin(), roundTrip.end(), interleaved.begin()));
+		}
+	}
+
+	assert(nois::kernel::Select(best));
+
+	// Channel arrays and slices read the samples in place
+	nois::FloatBuffer planar(k_NumFrames, 2);
+	planar.Fill(0.0f);
+
+	nois::f32_t left[k_NumFrames];
+	nois::f32_t right[k_NumFrames];
+	nois::f32_t* channels[] = { left, right };
+
+	for (nois::count_t f = 0; f < k_NumFrames; ++f)
+	{
+		left[f] = static_cast<nois::f32_t>(f);
+		right[f] = -static_cast<nois::f32_t>(f);
+	}
+
+	nois::StridedFloatBufferView split(channels, k_NumFrames, 2);
+	nois::ConstStridedFloatBufferView slice = split.Slice(30, 100);
+	assert(!slice.IsPlanar() && slice.GetNumFrames() == 7 && slice(2, 1) == -32.0f);
+
+	slice.CopyTo(planar);
+	assert(planar(0, 0) == 30.0f && planar(6, 1) == -36.0f && planar(7, 0) == 0.0f);
+
+	// Interleaved host buffers run without a conversion on the way out
+	nois::FloatRegistry registry;
+	registry.SetSink(registry.CreateStream<OffsetStream>(1.0f));
+	registry.PrepareMax(64, 2, 48000.0f);
+
+	std::vector<nois::f32_t> hostIn(k_NumFrames * 2);
+	std::vector<nois::f32_t> hostOut(k_NumFrames * 2, 0.0f);
+
+	for (nois::count_t i = 0; i < static_cast<nois::count_t>(hostIn.size()); ++i)
+	{
+		hostIn[i] = static_cast<nois::f32_t>(i);
+	}
+
+	int numAllocations = g_NumAllocations.load();
+	Result result = registry.Run(
+		nois::ConstStridedFloatBufferView::Interleaved(hostIn.data(), k_NumFrames, 2),
+		nois::StridedFloatBufferView::Interleaved(hostOut.data(), k_NumFrames, 2),
+		48000.0f);
+	assert(g_NumAllocations.load() == numAllocations);
+	assert(result == Result::Success);
+
+	for (nois::count_t i = 0; i < static_cast<nois::count_t>(hostOut.size()); ++i)
+	{
+		assert(hostOut[i] == hostIn[i] + 1.0f);
+	}
+
+	// Planar input is handed to the graph as it is
+	nois::FloatBuffer planarIn = MakeInput(k_NumFrames, 2, 2.0f);
+	result = registry.Run(
+		nois::ConstStridedFloatBufferView::Planar(planarIn.Data(), k_NumFrames, 2),
+		nois::StridedFloatBufferView(channels, k_NumFrames, 2),
+		48000.0f);
+	assert(result == Result::Success);
+	assert(left[0] == 3.0f && right[k_NumFrames - 1] == 3.0f);
+
+	// Buses without channels are never read, the output is silenced
+	const nois::f32_t* noChannels[] = { nullptr };
+	result = registry.Run(
+		nois::ConstStridedFloatBufferView(noChannels, k_NumFrames, 0),
+		nois::StridedFloatBufferView(channels, k_NumFrames, 2),
+		48000.0f);
+	assert(result == Result::Starved);
+	assert(left[0] == 0.0f && right[k_NumFrames - 1] == 0.0f);
+
+	// A mono graph into stereo host arrays silences the channel it doesn't have
+	nois::FloatBuffer monoIn = MakeInput(k_NumFrames, 1, 2.0f);
+	std::fill_n(left, k_NumFrames, 7.0f);
+	std::fill_n(right, k_NumFrames, 7.0f);
+	result = registry.Run(
+		nois::ConstStridedFloatBufferView::Planar(monoIn.Data(), k_NumFrames, 1),
+		nois::StridedFloatBufferView(channels, k_NumFrames, 2),
+		48000.0f);
+	assert(result == Result::Success);
+	assert(left[0] == 3.0f && left[k_NumFrames - 1] == 3.0f);
+	assert(right[0] == 0.0f && right[k_NumFrames - 1] == 0.0f);
+
+	// Planar output gets the same, channel by channel
+	nois::FloatBuffer stereoOut(k_NumFrames, 2);
+	stereoOut.Fill(7.0f);
+	assert(registry.Run(monoIn, stereoOut, 48000.0f) == Result::Success);
+	assert(stereoOut(0, 0) == 3.0f && stereoOut(k_NumFrames - 1, 0) == 3.0f);
+	assert(stereoOut(0, 1) == 0.0f && stereoOut(k_NumFrames - 1, 1) == 0.0f);
+}
+
+static void test_registry_control_rate()
+{
+	nois::FloatRegistry registry;
+
+	nois::count_t base = 0;
+	auto frame = registry.CreateSampleBinder(
+		[&base](nois::count_t f)
+		{
+			return static_cast<nois::f32_t>(base + f);
+		});
+
+	int numCalls = 0;
+	auto scaled = frame->Transform(
+		[&numCalls](nois::f32_t x)
+		{
+			++numCalls;
+			return 10.0f * x;
+		});
+	scaled->SetControlInterval(8);
+
+	nois::f32_t bound = 1.0f;
+	auto held = registry.CreateBlockBinder(
+		[&bound]()
+		{
+			return bound;
+		});
+	auto doubled = held->Transform(
+		[](nois::f32_t x)
+		{
+			return 2.0f * x;
+		});
+	doubled->SetControlInterval(16);
+
+	nois::ParameterSlot<nois::f32_t> slots[2] = { 0.0f, 0.0f };
+	slots[0].Use(scaled);
+	slots[1].Use(doubled);
+
+	auto in = MakeInput(32, 1, 1.0f);
+	nois::FloatBuffer out(32, 1);
+	registry.SetSink(registry.CreateStream<nois::Gainer>());
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	// One call to start from and one per interval, a linear input comes out exact
+	auto span = scaled->Block()->Span();
+	assert(numCalls == 5);
+	assert(span.shape == nois::BlockShape::Linear);
+
+	for (nois::count_t f = 0; f < 32; ++f)
+	{
+		assert(std::abs(span[f] - 10.0f * static_cast<nois::f32_t>(f)) < 1e-4f);
+	}
+
+	// Once per block ramps from where the last block ended
+	scaled->SetControlInterval(0);
+	base = 32;
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	span = scaled->Block()->Span();
+	assert(numCalls == 6);
+	assert(std::abs(span[0] - 320.0f) < 1e-3f && span[31] == 630.0f);
+
+	// Constant inputs ramp to their new value over one interval and then hold
+	bound = 3.0f;
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	auto ramped = doubled->Block()->Span();
+	assert(std::abs(ramped[7] - 4.0f) < 1e-5f && ramped[15] == 6.0f && ramped[31] == 6.0f);
+
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(doubled->Block()->Span().IsConstant());
+}
+
+static void test_registry_slot_rebinding()
+{
+	nois::FloatRegistry registry;
+
+	nois::Ref_t<nois::FloatParameter> one = registry.CreateBlockBinder([]() { return 1.0f; });
+	nois::Ref_t<nois::FloatParameter> two = registry.CreateSampleBinder([](nois::count_t) { return 2.0f; });
+
+	auto gainer = registry.CreateStream<nois::Gainer>();
+	gainer->SetGain(one);
+	registry.SetSink(gainer);
+
+	auto in = MakeInput(8, 1, 1.0f);
+	nois::FloatBuffer out(8, 1);
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(out[0] == 1.0f);
+
+	// Rebinding is only pointer swaps and reference counts
+	int numAllocations = g_NumAllocations.load();
+	gainer->SetGain(two);
+	assert(g_NumAllocations.load() == numAllocations);
+
+	// Handing out block readers doesn't allocate either
+	auto reader = two->Block();
+	assert(g_NumAllocations.load() == numAllocations);
+
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(out[0] == 2.0f && out[7] == 2.0f);
+
+	// Readers made before anything is used pick up later bindings with a change
+	nois::ParameterSlot<nois::f32_t> slot = 0.5f;
+	auto slotReader = slot.GetBlock();
+	auto slotStream = slot.Get();
+	assert(!slotReader->Span().changed && slotStream->Next().Value() == 0.5f);
+
+	slot.Use(one);
+	auto slotSpan = slotReader->Span();
+	assert(slotSpan.changed && slotSpan[0] == 1.0f);
+	auto next = slotStream->Next();
+	assert(next.Changed() && next.Value() == 1.0f);
+
+	// Unbinding goes back to the default, again with a change
+	slot.Use(nullptr);
+	assert(!one->IsSlotted());
+	slotSpan = slotReader->Span();
+	assert(slotSpan.changed && slotSpan.IsConstant() && slotSpan[0] == 0.5f);
+	next = slotStream->Next();
+	assert(next.Changed() && next.Value() == 0.5f);
+	next = slotStream->Next();
+	assert(!next.Changed() && next.Value() == 0.5f);
+
+	// Streaming walks the block frame by frame and starts over with the next one
+	auto frameIndex = registry.CreateSampleBinder([](nois::count_t f) { return static_cast<nois::f32_t>(f); });
+	registry.Commit();
+	slot.Use(frameIndex);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	for (int block = 0; block < 2; ++block)
+	{
+		for (nois::count_t f = 0; f < 8; ++f)
+		{
+			assert(slotStream->Next().Value() == static_cast<nois::f32_t>(f));
+		}
+	}
+
+	// Rerouting from another thread while blocks run only ever shows either source
+	std::atomic<bool> isDone = false;
+	std::thread router(
+		[&]()
+		{
+			for (int i = 0; i < 2000; ++i)
+			{
+				gainer->SetGain(i % 2 ? one : two);
+			}
+
+			isDone.store(true, std::memory_order_release);
+		});
+
+	while (!isDone.load(std::memory_order_acquire))
+	{
+		assert(registry.Run(in, out, 48000.0f) == Result::Success);
+		assert(out[0] == 1.0f || out[0] == 2.0f);
+	}
+
+	router.join();
+}
+
+static void test_registry_queue_parameter()
+{
+	nois::FloatRegistry registry;
+
+	auto gain = registry.CreateQueue(1.0f, 4);
+	auto gainer = registry.CreateStream<nois::Gainer>();
+	gainer->SetGain(gain);
+	registry.SetSink(gainer);
+
+	auto in = MakeInput(8, 1, 1.0f);
+	nois::FloatBuffer out(8, 1);
+
+	// Changes hold from their frame on, the last one at a frame wins and late ones can't go back
+	assert(gain->Push(2.0f, 0));
+	assert(gain->Push(3.0f, 4));
+	assert(gain->Push(5.0f, 4));
+	assert(gain->Push(4.0f, 2));
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	for (nois::count_t f = 0; f < 8; ++f)
+	{
+		assert(out[f] == (f < 4 ? 2.0f : 4.0f));
+	}
+
+	// Quiet blocks settle into a constant without a change
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	auto span = gain->Block()->Span();
+	assert(span.IsConstant() && !span.changed && span[0] == 4.0f);
+
+	// A full ring coalesces into one held back change that lands once there's room
+	bool isHeld = false;
+
+	for (int i = 0; i < 10; ++i)
+	{
+		isHeld = !gain->Push(static_cast<nois::f32_t>(10 + i)) || isHeld;
+	}
+
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(isHeld && out[0] == 13.0f && out[7] == 13.0f);
+	assert(gain->Flush());
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(out[0] == 19.0f && out[7] == 19.0f);
+
+	// Nothing reads it yet, the ring still drains every block and binding starts from the latest change
+	auto idle = registry.CreateQueue(0.0f, 4);
+	registry.Commit();
+
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			assert(idle->Push(static_cast<nois::f32_t>(i * 4 + j)));
+		}
+
+		assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	}
+
+	gainer->SetGain(idle);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(out[0] == 11.0f && out[7] == 11.0f);
+
+	// A control thread bursting changes never shows the audio thread an older value
+	nois::FloatRegistry streamed;
+	auto level = streamed.CreateQueue(0.0f, 64);
+	auto streamedGainer = streamed.CreateStream<nois::Gainer>();
+	streamedGainer->SetGain(level);
+	streamed.SetSink(streamedGainer);
+
+	std::atomic<bool> isDone = false;
+	std::thread producer(
+		[&]()
+		{
+			for (int i = 1; i <= 5000; ++i)
+			{
+				level->Push(static_cast<nois::f32_t>(i), i % 8);
+			}
+
+			while (!level->Flush())
+			{
+				std::this_thread::yield();
+			}
+
+			isDone.store(true, std::memory_order_release);
+		});
+
+	nois::f32_t last = 0.0f;
+	bool isFinished = false;
+
+	streamed.Commit();
+
+	while (!isFinished)
+	{
+		isFinished = isDone.load(std::memory_order_acquire);
+		assert(streamed.Run(in, out, 48000.0f) == Result::Success);
+
+		for (nois::count_t f = 0; f < 8; ++f)
+		{
+			assert(out[f] >= last);
+			last = out[f];
+		}
+	}
+
+	producer.join();
+	assert(streamed.Run(in, out, 48000.0f) == Result::Success);
+	assert(out[7] == 5000.0f);
+}
+
+// Block reader with a settable constant or per-frame target
+class TargetReader : public nois::IBlockReader<nois::f32_t>
+{
+public:
+	Point Get(nois::count_t f) const override
+	{
+		return { Span()[f], true };
+	}
+
+	nois::BlockSpan<nois::f32_t> Span() override
+	{
+		return const_cast<const TargetReader*>(this)->Span();
+	}
+
+	nois::BlockSpan<nois::f32_t> Span() const
+	{
+		if (ramp.empty())
+		{
+			return { &value, 0, 0, true };
+		}
+
+		return { ramp.data(), 1, static_cast<nois::count_t>(ramp.size()), true, nullptr, nois::BlockShape::Arbitrary };
+	}
+
+	nois::f32_t value = 0.0f;
+	std::vector<nois::f32_t> ramp;
+};
+
+static void test_registry_smoothing_bank()
+{
+	// Five lanes so the second quad is padded
+	std::vector<nois::Ref_t<TargetReader>> targets;
+	nois::SmoothingBank bank;
+
+	for (int i = 0; i < 5; ++i)
+	{
+		targets.push_back(nois::MakeRef<TargetReader>());
+		targets.back()->value = static_cast<nois::f32_t>(i);
+
+		// 8 frame ramps at 1 kHz
+		bank.Add(targets.back(), 0.008f, i == 4 ? nois::SmoothingBank::Ramp::Linear : nois::SmoothingBank::Ramp::OnePole);
+	}
+
+	bank.Prepare(16, 1000.0f);
+
+	// Lanes start settled on their targets
+	bank.Process(16);
+	assert(bank.GetNumActive() == 0);
+	assert(bank.Span(3).IsConstant() && bank.Span(3)[7] == 3.0f);
+
+	targets[1]->value = 2.0f;
+	targets[4]->value = 12.0f;
+	bank.Process(16);
+	assert(bank.GetNumActive() == 2);
+	assert(bank.Span(0).IsConstant() && bank.Span(2)[15] == 2.0f);
+
+	// The quad kernel matches the scalar one-pole
+	nois::f32_t coeff = 1.0f - std::exp(-1.0f / 8.0f);
+	nois::f32_t expected = 1.0f;
+
+	for (nois::count_t f = 0; f < 16; ++f)
+	{
+		expected += (2.0f - expected) * coeff;
+		assert(std::abs(bank.Span(1)[f] - expected) < 1e-5f);
+	}
+
+	// The linear lane lands on its target after exactly the ramp length
+	for (nois::count_t f = 0; f < 16; ++f)
+	{
+		nois::f32_t ramped = f < 7 ? 4.0f + static_cast<nois::f32_t>(f + 1) : 12.0f;
+		assert(std::abs(bank.Span(4)[f] - ramped) < 1e-5f);
+	}
+
+	// Targets moving within a block are followed frame by frame
+	targets[0]->ramp.assign(16, 5.0f);
+	bank.Process(16);
+	assert(!bank.Span(0).IsConstant() && bank.Span(0)[0] > 0.0f && bank.Span(0)[15] > bank.Span(0)[0]);
+
+	targets[0]->ramp.clear();
+	targets[0]->value = 5.0f;
+
+	for (int i = 0; i < 100 && bank.GetNumActive() > 0; ++i)
+	{
+		bank.Process(16);
+	}
+
+	bank.Process(16);
+	assert(bank.GetNumActive() == 0);
+	assert(bank.IsSettled(0) && bank.IsSettled(1) && bank.IsSettled(4));
+	assert(bank.Span(0)[0] == 5.0f && bank.Span(1)[0] == 2.0f && bank.Span(4)[0] == 12.0f);
+}
+
+static void test_registry_change_bits()
+{
+	nois::FloatRegistry registry;
+
+	// Steps past the first word of change bits
+	nois::count_t stepFrame = 70;
+	auto step = registry.CreateSampleBinder(
+		[&stepFrame](nois::count_t f)
+		{
+			return f < stepFrame ? 0.0f : 1.0f;
+		});
+
+	nois::ParameterSlot<nois::f32_t> slot = 0.0f;
+	slot.Use(step);
+
+	auto in = MakeInput(100, 1, 0.0f);
+	// There is no sink, Run() only updates parameters
+	nois::FloatBuffer out(100, 1);
+
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Starved);
+
+	auto reader = step->Block();
+	auto span = reader->Span();
+
+	assert(reinterpret_cast<uintptr_t>(span.values) % nois::k_SimdAlignment == 0);
+	assert(!span.IsConstant() && span.changed);
+	assert(span.NextChange(0) == 70);
+	assert(span.NextChange(71) == 100);
+	assert(reader->Get(70).Changed() && !reader->Get(69).Changed());
+
+	// The block boundary counts too, the last block ended on a different value
+	assert(registry.Run(in, out, 48000.0f) == Result::Starved);
+	assert(reader->Span().NextChange(0) == 0);
+	assert(reader->Span().NextChange(1) == 70);
+
+	stepFrame = 100;
+	assert(registry.Run(in, out, 48000.0f) == Result::Starved);
+	span = reader->Span();
+	assert(span.IsConstant() && span.changed);
+	assert(span.NextChange(0) == 0 && span.NextChange(1) == 100);
+
+	assert(registry.Run(in, out, 48000.0f) == Result::Starved);
+	assert(!reader->Span().changed && reader->Span().NextChange(0) == 100);
+}
+
+static void test_registry_block_shapes()
+{
+	nois::FloatRegistry registry;
+
+	auto ramp = registry.CreateSampleBinder(
+		[](nois::count_t f)
+		{
+			return 1.0f + 0.5f * static_cast<nois::f32_t>(f);
+		});
+	auto noise = registry.CreateSampleBinder(
+		[](nois::count_t f)
+		{
+			return static_cast<nois::f32_t>(f * f);
+		});
+	nois::ParameterSlot<nois::f32_t> noiseSlot = 0.0f;
+	noiseSlot.Use(noise);
+
+	auto gainer = registry.CreateStream<nois::Gainer>();
+	gainer->SetGain(ramp);
+	registry.SetSink(gainer);
+
+	auto in = MakeInput(32, 2, 2.0f);
+	nois::FloatBuffer out(32, 2);
+
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	auto rampSpan = ramp->Block()->Span();
+	assert(rampSpan.shape == nois::BlockShape::Linear && rampSpan.step == 0.5f);
+	assert(noise->Block()->Span().shape == nois::BlockShape::Arbitrary);
+
+	// The ramp kernel has to land on the same values as reading every frame
+	for (nois::count_t c = 0; c < 2; ++c)
+	{
+		for (nois::count_t f = 0; f < 32; ++f)
+		{
+			assert(std::abs(out(f, c) - 2.0f * rampSpan[f]) < 1e-5f);
+		}
+	}
+
+	gainer->SetGain(noise);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(out(31, 1) == 2.0f * 961.0f);
+}
+
+static void test_registry_demand()
+{
+	nois::FloatRegistry registry;
+
+	int numBinds = 0;
+	int numIdleBinds = 0;
+	auto gain = registry.CreateSampleBinder(
+		[&numBinds](nois::count_t f)
+		{
+			++numBinds;
+			return 1.0f;
+		});
+	auto idle = registry.CreateBlockBinder(
+		[&numIdleBinds]()
+		{
+			++numIdleBinds;
+			return 1.0f;
+		});
+	auto halved = gain->Transform(
+		[](nois::f32_t x)
+		{
+			return x * 0.5f;
+		});
+
+	auto gainer = registry.CreateStream<nois::Gainer>();
+	registry.SetSink(gainer);
+
+	auto in = MakeInput(8, 1, 1.0f);
+	nois::FloatBuffer out(8, 1);
+
+	registry.Commit();
+
+	// Nothing slotted, nothing evaluated
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(numBinds == 0 && numIdleBinds == 0);
+
+	// Slotting the transformer pulls in what it's transformed from
+	gainer->SetGain(halved);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(numBinds == 8 && numIdleBinds == 0);
+	assert(out[7] == 0.5f);
+
+	gainer->SetGain(idle);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(numBinds == 8 && numIdleBinds == 1);
+	assert(!halved->IsSlotted() && idle->IsSlotted());
+
+	// Never prepared, a block still reads as its starting value
+	auto spare = registry.CreateSampleBinder(
+		[](nois::count_t f)
+		{
+			return 2.0f;
+		});
+	auto span = spare->Block()->Span();
+	assert(span.values && span.IsConstant() && span[0] == 0.0f);
+
+	// Sized with the graph even while idle, so slotting it later reads a prepared block
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	gainer->SetGain(spare);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(out[0] == 2.0f && out[7] == 2.0f);
+}
+
+static void test_registry_block_transformer()
+{
+	nois::FloatRegistry registry;
+
+	auto ramp = registry.CreateSampleBinder(
+		[](nois::count_t f)
+		{
+			return -60.0f + 2.0f * static_cast<nois::f32_t>(f);
+		});
+	auto normalized = registry.CreateSampleBinder(
+		[](nois::count_t f)
+		{
+			return static_cast<nois::f32_t>(f) / 36.0f;
+		});
+	auto fixed = registry.CreateBlockBinder(
+		[]()
+		{
+			return 150.0f;
+		});
+
+	int numCalls = 0;
+	int numConstantFrames = 0;
+	auto sum = registry.CreateBlockTransformer(
+		[&](nois::f32_t* out, nois::count_t numFrames, const nois::BlockSpan<nois::f32_t>& a, const nois::BlockSpan<nois::f32_t>& b)
+		{
+			++numCalls;
+			numConstantFrames = numFrames;
+
+			for (nois::count_t f = 0; f < numFrames; ++f)
+			{
+				out[f] = a[f] + b[f];
+			}
+		},
+		fixed,
+		fixed);
+
+	auto scaled = fixed->TransformBlock(nois::mapping::ScaleOffset{ 0.01f, 0.5f });
+	auto gain = ramp->TransformBlock(nois::mapping::DbToLinear{});
+	auto frequency = normalized->TransformBlock(nois::mapping::ExpRange{ 20.0f, 20000.0f });
+	auto clamped = ramp->TransformBlock(nois::mapping::Clamp{ -40.0f, -10.0f });
+
+	nois::ParameterSlot<nois::f32_t> slots[5] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	slots[0].Use(sum);
+	slots[1].Use(scaled);
+	slots[2].Use(gain);
+	slots[3].Use(frequency);
+	slots[4].Use(clamped);
+
+	auto in = MakeInput(37, 1, 1.0f);
+	nois::FloatBuffer out(37, 1);
+	registry.SetSink(registry.CreateStream<nois::Gainer>());
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	// Constant inputs are transformed once and broadcast
+	auto sumSpan = sum->Block()->Span();
+	assert(numCalls == 1 && numConstantFrames == 1);
+	assert(sumSpan.IsConstant() && sumSpan[0] == 300.0f);
+	assert(scaled->Block()->Span()[0] == 2.0f);
+
+	// Vector kernels and the scalar tail have to agree with the reference
+	auto gainSpan = gain->Block()->Span();
+	auto frequencySpan = frequency->Block()->Span();
+	auto clampedSpan = clamped->Block()->Span();
+
+	for (nois::count_t f = 0; f < 37; ++f)
+	{
+		nois::f32_t db = -60.0f + 2.0f * static_cast<nois::f32_t>(f);
+		nois::f32_t x = static_cast<nois::f32_t>(f) / 36.0f;
+
+		assert(std::abs(gainSpan[f] - nois::FromDb(db)) <= 1e-5f * nois::FromDb(db));
+		assert(std::abs(frequencySpan[f] - 20.0f * std::pow(1000.0f, x)) <= 1e-5f * frequencySpan[f]);
+		assert(clampedSpan[f] == std::clamp(db, -40.0f, -10.0f));
+	}
+}
+
+static void test_registry_executor()
+{
+	auto executor = nois::Executor::Create(3);
+
+	nois::FloatRegistry serial;
+	nois::FloatRegistry parallel;
+	parallel.SetExecutor(executor);
+
+	// Diamond with a long side branch
+	for (auto* registry : { &serial, &parallel })
+	{
+		auto root = registry->CreateStream<OffsetStream>(1.0f);
+		auto left = registry->CreateStream<OffsetStream>(2.0f);
+		auto right = registry->CreateStream<OffsetStream>(3.0f);
+		auto rightMore = registry->CreateStream<OffsetStream>(4.0f);
+		auto join = registry->CreateStream<OffsetStream>(5.0f);
+
+		registry->Connect(root, left);
+		registry->Connect(root, right);
+		registry->Connect(right, rightMore);
+		registry->Connect(left, join);
+		registry->Connect(rightMore, join);
+		registry->SetSink(join);
+	}
+
+	auto in = MakeInput(128, 2, 0.25f);
+	nois::FloatBuffer serialOut(128, 2);
+	nois::FloatBuffer parallelOut(128, 2);
+
+	serial.Commit();
+	parallel.Commit();
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		assert(serial.Run(in, serialOut, 48000.0f) == Result::Success);
+		assert(parallel.Run(in, parallelOut, 48000.0f) == Result::Success);
+
+		for (nois::count_t s = 0; s < serialOut.GetSize(); ++s)
+		{
+			assert(serialOut[s] == parallelOut[s]);
+		}
+	}
+
+	assert(serialOut[0] == 16.5f);
+}
+
+static void test_registry_shared_executor()
+{
+	auto executor = nois::Executor::Create(3);
+	executor->Reserve(4);
+
+	// A second caller is refused while a graph is running, here from inside the graph
+	{
+		struct Nested
+		{
+			nois::Executor* executor;
+			const nois::Executor::Graph* graph;
+			bool isExecuted;
+		};
+
+		nois::count_t numDependencies[1] = { 0 };
+		nois::count_t dependentOffsets[2] = { 0, 0 };
+
+		nois::Executor::Graph graph;
+		graph.numTasks = 1;
+		graph.numDependencies = numDependencies;
+		graph.dependentOffsets = dependentOffsets;
+		graph.run = [](void* context, nois::count_t)
+		{
+			auto* nested = static_cast<Nested*>(context);
+			nested->isExecuted = nested->executor->Execute(*nested->graph);
+		};
+
+		Nested nested = { executor.get(), &graph, true };
+		graph.context = &nested;
+
+		assert(executor->Execute(graph));
+		assert(!nested.isExecuted);
+	}
+
+	// Two audio threads on one executor, whoever loses the race runs serially
+	auto run = [&](float offset)
+	{
+		nois::FloatRegistry registry;
+		registry.SetExecutor(executor);
+
+		auto root = registry.CreateStream<OffsetStream>(offset);
+		auto join = registry.CreateStream<OffsetStream>(1.0f);
+
+		for (int i = 0; i < 8; ++i)
+		{
+			auto branch = registry.CreateStream<OffsetStream>(1.0f);
+			registry.Connect(root, branch);
+			registry.Connect(branch, join);
+		}
+
+		registry.SetSink(join);
+		registry.Commit();
+
+		auto in = MakeInput(64, 2, 0.0f);
+		nois::FloatBuffer out(64, 2);
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+			for (nois::count_t s = 0; s < out.GetSize(); ++s)
+			{
+				assert(out[s] == 8.0f * (offset + 1.0f) + 1.0f);
+			}
+		}
+	};
+
+	std::atomic<bool> isDone = false;
+
+	// Growing the queues from a control thread waits for whichever graph is running
+	std::thread control([&]
+	{
+		for (nois::count_t i = 0; !isDone.load(); ++i)
+		{
+			executor->Reserve(256 + 16 * (i % 64));
+		}
+	});
+
+	std::thread first(run, 1.0f);
+	std::thread second(run, 2.0f);
+
+	first.join();
+	second.join();
+
+	isDone.store(true);
+	control.join();
+}
+
+static void test_registry_fan_in()
+{
+	nois::FloatRegistry registry;
+
+	auto a = registry.CreateStream<OffsetStream>(1.0f);
+	auto b = registry.CreateStream<OffsetStream>(2.0f);
+	auto c = registry.CreateStream<OffsetStream>(3.0f);
+	auto mix = registry.CreateStream<OffsetStream>(0.0f);
+
+	registry.Connect(a, mix);
+	registry.Connect(b, mix);
+	registry.Connect(c, mix);
+	registry.SetSink(mix);
+
+	auto in = MakeInput(32, 2, 1.0f);
+	nois::FloatBuffer out(32, 2);
+
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	for (nois::count_t i = 0; i < out.GetSize(); ++i)
+	{
+		assert(out[i] == 2.0f + 3.0f + 4.0f);
+	}
+}
+
+static void test_registry_pooled_buffers()
+{
+	nois::FloatRegistry registry;
+
+	// Long chain with a tap early on that rejoins at the end,
+	// the tapped buffer must survive while the chain recycles the rest
+	std::vector<nois::Ref_t<OffsetStream>> chain;
+	for (int i = 0; i < 40; ++i)
+	{
+		chain.push_back(registry.CreateStream<OffsetStream>(1.0f));
+		if (i > 0)
+		{
+			registry.Connect(chain[i - 1], chain[i]);
+		}
+	}
+
+	auto tap = registry.CreateStream<OffsetStream>(100.0f);
+	auto join = registry.CreateStream<OffsetStream>(0.0f);
+	registry.Connect(chain[4], tap);
+	registry.Connect(tap, join);
+	registry.Connect(chain.back(), join);
+	registry.SetSink(join);
+
+	auto in = MakeInput(512, 2, 0.0f);
+	nois::FloatBuffer out(512, 2);
+
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	for (nois::count_t i = 0; i < out.GetSize(); ++i)
+	{
+		assert(out[i] == 40.0f + 105.0f);
+	}
+}
+
+static void test_registry_in_place()
+{
+	nois::FloatRegistry registry;
+
+	// In-place chain with a tap, the tapped output must not be overwritten
+	std::vector<nois::Ref_t<OffsetStream>> chain;
+	for (int i = 0; i < 8; ++i)
+	{
+		chain.push_back(registry.CreateStream<OffsetStream>(1.0f, nullptr, true));
+		if (i > 0)
+		{
+			registry.Connect(chain[i - 1], chain[i]);
+		}
+	}
+
+	auto tap = registry.CreateStream<OffsetStream>(10.0f, nullptr, true);
+	auto join = registry.CreateStream<OffsetStream>(0.0f, nullptr, true);
+	registry.Connect(chain[2], tap);
+	registry.Connect(chain.back(), join);
+	registry.Connect(tap, join);
+	registry.SetSink(join);
+
+	auto in = MakeInput(64, 2, 0.5f);
+	nois::FloatBuffer out(64, 2);
+
+	registry.Commit();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	for (nois::count_t i = 0; i < out.GetSize(); ++i)
+	{
+		assert(out[i] == 8.5f + 13.5f);
+	}
+
+	// Input given to the registry is never written
+	assert(in[0] == 0.5f);
+}
+
+static void test_registry_hot_swap(nois::Ref_t<nois::Executor> executor)
+{
+	nois::FloatRegistry registry;
+
+	if (executor)
+	{
+		registry.SetExecutor(executor);
+	}
+
+	auto head = registry.CreateStream<OffsetStream>(1.0f);
+	registry.SetSink(head);
+
+	auto in = MakeInput(64, 2, 0.0f);
+	nois::FloatBuffer out(64, 2);
+	out.Fill(1.0f);
+
+	// Nothing is compiled on the audio thread, until a commit it plays silence
+	assert(registry.Run(in, out, 48000.0f) == Result::Starved);
+	assert(out[0] == 0.0f && head->numPrepares == 0);
+
+	registry.PrepareMax(64, 2, 48000.0f);
+
+	std::atomic<bool> isRunning = true;
+	std::atomic<int> numRuns = 0;
+
+	// Audio thread keeps running while the chain grows
+	std::thread audio(
+		[&]()
+		{
+			auto in = MakeInput(64, 2, 0.0f);
+			nois::FloatBuffer out(64, 2);
+			int numAllocations = t_NumAllocations;
+
+			while (isRunning.load())
+			{
+				assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+				// New nodes were prepared by the commit that added them
+				assert(t_NumAllocations == numAllocations);
+
+				// Whatever plan ran, it was a whole chain of +1 nodes
+				nois::f32_t value = out[0];
+				assert(value >= 1.0f && value == std::floor(value));
+
+				for (nois::count_t i = 0; i < out.GetSize(); ++i)
+				{
+					assert(out[i] == value);
+				}
+
+				++numRuns;
+			}
+		});
+
+	auto tail = head;
+	for (int i = 0; i < 50; ++i)
+	{
+		auto next = registry.CreateStream<OffsetStream>(1.0f);
+		registry.Connect(tail, next);
+		registry.SetSink(next);
+
+		// Dead end that allocates its line when prepared
+		auto branch = registry.CreateStream<DelayStream>(16);
+		registry.Connect(tail, branch);
+
+		registry.Commit();
+		tail = next;
+
+		int seen = numRuns.load();
+		while (numRuns.load() < seen + 2)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	isRunning = false;
+	audio.join();
+
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	assert(out[0] == 51.0f);
+	assert(head->numPrepares == 1);
+
+	// Commit prepares what it adds, swapping in the plan allocates nothing
+	auto last = registry.CreateStream<OffsetStream>(1.0f);
+	registry.Connect(tail, last);
+	registry.SetSink(last);
+	registry.Commit();
+
+	int numAllocations = g_NumAllocations.load();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(g_NumAllocations.load() == numAllocations);
+	assert(out[0] == 52.0f);
+}
+
+static void test_registry_silence()
+{
+	nois::FloatRegistry registry;
+
+	// Pass-through streams, one rings for a while and one stops right away
+	auto ringing = registry.CreateStream<OffsetStream>(0.0f);
+	auto dry = registry.CreateStream<OffsetStream>(0.0f);
+	ringing->tailFrames = 100;
+	dry->tailFrames = 0;
+	registry.Connect(ringing, dry);
+	registry.SetSink(dry);
+
+	auto silence = MakeInput(64, 2, 0.0f);
+	nois::FloatBuffer out(64, 2);
+	out.Fill(1.0f);
+
+	// 64 then 100 frames of tail, the third block has nothing left to ring
+	// The streams report success while they run and the skipped sink reports silence
+	for (int i = 0; i < 3; ++i)
+	{
+		registry.Commit();
+		assert(registry.Run(silence, out, 48000.0f) == (i < 2 ? Result::Success : Result::Silent));
+	}
+
+	assert(ringing->numProcesses == 2);
+	assert(dry->numProcesses == 2);
+	assert(out[0] == 0.0f);
+
+	// Sound wakes the chain straight back up
+	auto in = MakeInput(64, 2, 0.5f);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	assert(ringing->numProcesses == 3);
+	assert(dry->numProcesses == 3);
+	assert(out[0] == 0.5f);
+}
+
+static void test_registry_compressor_tail()
+{
+	nois::FloatRegistry registry;
+
+	auto compressor = registry.CreateStream<nois::Compressor>();
+	compressor->SetThresholdDb(registry.CreateBlockBinder([]() { return -20.0f; }));
+	compressor->SetRatio(registry.CreateBlockBinder([]() { return 4.0f; }));
+	registry.SetSink(compressor);
+	registry.PrepareMax(64, 1, 48000.0f);
+
+	auto in = MakeInput(64, 1, 1.0f);
+	nois::FloatBuffer out(64, 1);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(out[63] < 1.0f);
+
+	// The 50 ms default release takes ln(10) time constants from full scale down to -20 dB
+	nois::count_t tailFrames = compressor->GetTailFrames();
+	assert(std::abs(static_cast<nois::f32_t>(tailFrames) - 2400.0f * std::log(10.0f)) < 2.0f);
+}
+
+static void test_registry_variable_block_size()
+{
+	nois::FloatRegistry registry;
+
+	auto frameIndex = registry.CreateSampleBinder(
+		[](nois::count_t f)
+		{
+			return static_cast<nois::f32_t>(f);
+		});
+	nois::ParameterSlot<nois::f32_t> slot = 0.0f;
+	slot.Use(frameIndex);
+
+	auto a = registry.CreateStream<OffsetStream>(1.0f);
+	auto b = registry.CreateStream<OffsetStream>(2.0f);
+	registry.Connect(a, b);
+	registry.SetSink(b);
+
+	registry.PrepareMax(256, 2, 48000.0f);
+	assert(a->numPrepares == 1);
+
+	auto stream = frameIndex->Stream();
+	auto block = frameIndex->Block();
+
+	for (nois::count_t numFrames : { 256, 100, 17, 1, 256, 64 })
+	{
+		auto in = MakeInput(numFrames, 2, 0.5f);
+		nois::FloatBuffer out(numFrames, 2);
+
+		assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+		for (nois::count_t i = 0; i < out.GetSize(); ++i)
+		{
+			assert(out[i] == 3.5f);
+		}
+
+		// Readers follow the block, streaming wraps after its last frame
+		assert(block->Get(numFrames - 1).Value() == static_cast<nois::f32_t>(numFrames - 1));
+		assert(block->Get(numFrames).Value() == 0.0f);
+
+		for (nois::count_t f = 0; f < numFrames; ++f)
+		{
+			assert(stream->Next().Value() == static_cast<nois::f32_t>(f));
+		}
+	}
+
+	// Nothing was prepared again
+	assert(a->numPrepares == 1);
+	assert(b->numPrepares == 1);
+
+	// A block past the maximum runs in pieces of it, without preparing or allocating
+	auto in = MakeInput(600, 2, 0.5f);
+	nois::FloatBuffer out(600, 2);
+
+	int numAllocations = g_NumAllocations.load();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(g_NumAllocations.load() == numAllocations);
+
+	assert(a->numPrepares == 1);
+
+	for (nois::count_t i = 0; i < out.GetSize(); ++i)
+	{
+		assert(out[i] == 3.5f);
+	}
+
+	// The reader saw the last piece
+	assert(block->Get(600 - 512 - 1).Value() == static_cast<nois::f32_t>(600 - 512 - 1));
+
+	// Without PrepareMax() the first block is no limit, a longer one prepares again
+	nois::FloatRegistry unprepared;
+	auto c = unprepared.CreateStream<OffsetStream>(1.0f);
+	unprepared.SetSink(c);
+	unprepared.Commit();
+
+	for (nois::count_t numFrames : { 1, 512, 64, 512 })
+	{
+		auto in = MakeInput(numFrames, 2, 0.5f);
+		nois::FloatBuffer out(numFrames, 2);
+
+		assert(unprepared.Run(in, out, 48000.0f) == Result::Success);
+		assert(out[0] == 1.5f && out[out.GetSize() - 1] == 1.5f);
+	}
+
+	assert(c->numProcesses == 4);
+	assert(c->numPrepares == 2);
+}
+
+static void test_registry_latency()
+{
+	nois::FloatRegistry registry;
+
+	// Diamond where one branch lags, the join must see both copies of the impulse together
+	auto root = registry.CreateStream<OffsetStream>(0.0f);
+	auto plain = registry.CreateStream<OffsetStream>(0.0f);
+	auto delayed = registry.CreateStream<DelayStream>(3);
+	auto join = registry.CreateStream<OffsetStream>(0.0f);
+
+	registry.Connect(root, plain);
+	registry.Connect(root, delayed);
+	registry.Connect(plain, join);
+	registry.Connect(delayed, join);
+	registry.SetSink(join);
+
+	auto in = MakeInput(8, 1, 0.0f);
+	nois::FloatBuffer out(8, 1);
+
+	in[0] = 1.0f;
+	registry.Commit();
+
+	// Known before the first block, hosts ask for it up front
+	assert(registry.GetLatencyFrames() == 3);
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	assert(registry.GetLatencyFrames() == 3);
+
+	for (nois::count_t f = 0; f < 8; ++f)
+	{
+		assert(out[f] == (f == 3 ? 2.0f : 0.0f));
+	}
+
+	// Both lines carry over into the next block
+	in.Zero();
+	in[6] = 1.0f;
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	in.Zero();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	for (nois::count_t f = 0; f < 8; ++f)
+	{
+		assert(out[f] == (f == 1 ? 2.0f : 0.0f));
+	}
+
+	// An edit elsewhere swaps the plan between blocks, the lines keep what they hold
+	in.Zero();
+	in[6] = 1.0f;
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	registry.CreateStream<OffsetStream>(0.0f);
+	registry.Commit();
+	in.Zero();
+	assert(registry.Run(in, out, 48000.0f) == Result::Success);
+
+	for (nois::count_t f = 0; f < 8; ++f)
+	{
+		assert(out[f] == (f == 1 ? 2.0f : 0.0f));
+	}
+
+	// The audio thread never grows the delays, more channels than compiled for
+	// run uncompensated until the next commit
+	auto stereoIn = MakeInput(8, 2, 0.0f);
+	nois::FloatBuffer stereoOut(8, 2);
+	stereoIn[0] = 1.0f;
+	assert(registry.Run(stereoIn, stereoOut, 48000.0f) == Result::Success);
+	assert(stereoOut[0] == 1.0f && stereoOut[3] == 1.0f);
+
+	registry.Commit();
+	assert(registry.Run(stereoIn, stereoOut, 48000.0f) == Result::Success);
+	assert(stereoOut[0] == 0.0f && stereoOut[3] == 2.0f);
+
+	// Compiling reads what the audio thread published, never the running stream itself
+	int numLatencyQueries = delayed->numLatencyQueries;
+	registry.CreateStream<OffsetStream>(0.0f);
+	registry.Commit();
+	assert(delayed->numLatencyQueries == numLatencyQueries);
+	assert(registry.GetLatencyFrames() == 3);
+}
+
+static void test_registry_timing()
+{
+	nois::FloatRegistry registry;
+
+	auto a = registry.CreateStream<OffsetStream>(1.0f);
+	auto b = registry.CreateStream<OffsetStream>(2.0f);
+	registry.Connect(a, b);
+	registry.SetSink(b);
+
+	auto in = MakeInput(64, 2, 0.0f);
+	nois::FloatBuffer out(64, 2);
+
+	// Counters are read while the audio thread keeps writing them
+	std::atomic<bool> isRunning = true;
+	std::thread reader(
+		[&]()
+		{
+			while (isRunning.load())
+			{
+				auto timing = registry.GetTiming();
+				assert(timing.lastNanos <= timing.maxNanos);
+			}
+		});
+
+	for (int i = 0; i < 100; ++i)
+	{
+		registry.Commit();
+		assert(registry.Run(in, out, 48000.0f) == Result::Success);
+	}
+
+	isRunning.store(false);
+	reader.join();
+
+	auto run = registry.GetTiming();
+	auto node = registry.GetTiming(a);
+
+	assert(run.numBlocks == 100);
+	assert(node.numBlocks == 100);
+	assert(node.averageNanos <= node.maxNanos);
+	assert(node.lastNanos <= run.lastNanos);
+	assert(run.lastLoad >= 0.0f && run.lastLoad <= run.maxLoad);
+	assert(registry.GetTiming(OffsetStream::Create(0.0f)).numBlocks == 0);
+}
+
+static void test_registry_render()
+{
+	constexpr nois::count_t k_NumFrames = 10000;
+
+	// Ramp so every block has to land at the right offset
+	nois::FloatBuffer in(k_NumFrames, 2);
+
+	for (nois::count_t c = 0; c < 2; ++c)
+	{
+		for (nois::count_t f = 0; f < k_NumFrames; ++f)
+		{
+			in(f, c) = static_cast<nois::f32_t>(f + c * k_NumFrames);
+		}
+	}
+
+	auto check = [&](const nois::FloatBuffer& out, nois::f32_t offset)
+	{
+		for (nois::count_t c = 0; c < 2; ++c)
+		{
+			for (nois::count_t f = 0; f < k_NumFrames; ++f)
+			{
+				assert(out(f, c) == in(f, c) + offset);
+			}
+		}
+	};
+
+	{
+		nois::FloatRegistry registry;
+
+		auto a = registry.CreateStream<OffsetStream>(1.0f);
+		auto b = registry.CreateStream<OffsetStream>(2.0f);
+		registry.Connect(a, b);
+		registry.SetSink(b);
+
+		nois::FloatBuffer out(k_NumFrames, 2);
+		registry.Commit();
+		registry.Render(in, out, 48000.0f, 4096);
+
+		check(out, 3.0f);
+		assert(a->numProcesses == 3);
+		assert(a->numPrepares == 1);
+	}
+
+	{
+		// Independent graphs spread over the executor
+		constexpr int k_NumJobs = 6;
+
+		nois::FloatRegistry registries[k_NumJobs];
+		nois::FloatBuffer outs[k_NumJobs];
+		std::vector<nois::FloatRegistry::RenderJob> jobs;
+
+		for (int j = 0; j < k_NumJobs; ++j)
+		{
+			auto a = registries[j].CreateStream<OffsetStream>(static_cast<nois::f32_t>(j));
+			registries[j].SetSink(a);
+			outs[j].Resize(k_NumFrames, 2);
+
+			nois::FloatRegistry::RenderJob job;
+			job.registry = &registries[j];
+			job.inBuffer = in;
+			job.outBuffer = outs[j];
+			job.sampleRate = 48000.0f;
+			jobs.emplace_back(job);
+		}
+
+		auto executor = nois::Executor::Create(3);
+		nois::FloatRegistry::RenderBatch(*executor, jobs, 1000);
+
+		for (int j = 0; j < k_NumJobs; ++j)
+		{
+			check(outs[j], static_cast<nois::f32_t>(j));
+		}
+	}
+}
+
+int main()
+{
+	std::cout << "Testing nois::Registry schedule..." << std::endl;
+	test_registry_chain_order();
+
+	std::cout << "Testing nois::Registry parameters..." << std::endl;
+	test_registry_parameters();
+
+	std::cout << "Testing nois::Registry block spans..." << std::endl;
+	test_registry_block_spans();
+
+	std::cout << "Testing nois::Registry change bits..." << std::endl;
+	test_registry_change_bits();
+
+	std::cout << "Testing nois::Registry block shapes..." << std::endl;
+	test_registry_block_shapes();
+
+	std::cout << "Testing nois::Registry automation..." << std::endl;
+	test_registry_automation();
+
+	std::cout << "Testing nois::Registry expression..." << std::endl;
+	test_registry_expression();
+
+	std::cout << "Testing nois::Registry shared transforms..." << std::endl;
+	test_registry_shared_transform();
+
+	std::cout << "Testing nois::kernel..." << std::endl;
+	test_buffer_kernels();
+
+	std::cout << "Testing nois::StridedBufferView..." << std::endl;
+	test_buffer_strided_view();
+
+	std::cout << "Testing nois::Registry control rate..." << std::endl;
+	test_registry_control_rate();
+
+	std::cout << "Testing nois::Registry slot rebinding..." << std::endl;
+	test_registry_slot_rebinding();
+
+	std::cout << "Testing nois::Registry queue parameter..." << std::endl;
+	test_registry_queue_parameter();
+
+	std::cout << "Testing nois::Registry smoothing bank..." << std::endl;
+	test_registry_smoothing_bank();
+
+	std::cout << "Testing nois::Registry parameter demand..." << std::endl;
+	test_registry_demand();
+
+	std::cout << "Testing nois::Registry block transformer..." << std::endl;
+	test_registry_block_transformer();
+
+	std::cout << "Testing nois::Registry executor..." << std::endl;
+	test_registry_executor();
+
+	std::cout << "Testing nois::Registry shared executor..." << std::endl;
+	test_registry_shared_executor();
+
+	std::cout << "Testing nois::Registry fan-in..." << std::endl;
+	test_registry_fan_in();
+
+	std::cout << "Testing nois::Registry pooled buffers..." << std::endl;
+	test_registry_pooled_buffers();
+
+	std::cout << "Testing nois::Registry in-place..." << std::endl;
+	test_registry_in_place();
+
+	std::cout << "Testing nois::Registry hot swap..." << std::endl;
+	test_registry_hot_swap(nullptr);
+
+	std::cout << "Testing nois::Registry hot swap with executor..." << std::endl;
+	test_registry_hot_swap(nois::Executor::Create(3));
+
+	std::cout << "Testing nois::Registry silence..." << std::endl;
+	test_registry_silence();
+
+	std::cout << "Testing nois::Compressor tail..." << std::endl;
+	test_registry_compressor_tail();
+
+	std::cout << "Testing nois::Registry variable block size..." << std::endl;
+	test_registry_variable_block_size();
+
+	std::cout << "Testing nois::Registry latency compensation..." << std::endl;
+	test_registry_latency();
+
+	std::cout << "Testing nois::Registry timing..." << std::endl;
+	test_registry_timing();
+
+	std::cout << "Testing nois::Registry offline render..." << std::endl;
+	test_registry_render();
+
+	std::cout << "All tests passed!" << std::endl;
+
+	return 0;
+}